@@ -1,259 +1,901 @@
-#include "corpus.h"
-#include <iostream>
-#include <fstream>
-#include <sstream>
-#include <map>
-#include "logging.h"
-#include <boost/assert.hpp>
-#include <boost/lexical_cast.hpp>
-#include <boost/algorithm/string.hpp>
-
-const char* Corpus::UNK  = "_UNK_";
-const char* Corpus::SPAN = "_SPAN_";
-const char* Corpus::BAD0 = "_BAD0_";
-const char* Corpus::ROOT = "_ROOT_";
-
-Corpus::Corpus() : n_train(0), n_devel(0) {
-
-}
-
-void Corpus::load_training_data(const std::string& filename) {
-  _INFO << "Corpus:: reading training data from: " << filename;
-
-  word_map.insert(Corpus::ROOT);
-  word_map.insert(Corpus::UNK);
-  // word_map.insert(Corpus::SPAN);
-  pos_map.insert(Corpus::ROOT);
-  pos_map.insert(Corpus::UNK);
-  char_map.insert(Corpus::UNK);
-  action_map.insert("CONFIRM");
-  action_map.insert(Corpus::UNK);
-
-  confirm_map[word_map.get(Corpus::UNK)] = Alphabet();
-  confirm_map[word_map.get(Corpus::UNK)].insert(Corpus::UNK);
-
-  std::ifstream in(filename);
-  BOOST_ASSERT_MSG(in, "Corpus:: failed to open the training file.");
-
-  n_train = 0;
-  std::string data;
-  std::string line;
-  while (std::getline(in, line)) {
-    boost::algorithm::trim(line);
-    if (line.empty()) {
-      parse_data(data, training_inputs[n_train], training_actions[n_train], true);
-      data = "";
-      ++n_train;
-    } else {
-      data += (line + "\n");
-    }
-  }
-  if (!data.empty()) {
-    parse_data(data, training_inputs[n_train], training_actions[n_train], true);
-    ++n_train;
-  }
-  _INFO << "Corpus:: loaded " << n_train << " training sentences.";
-}
-
-void Corpus::load_devel_data(const std::string& filename) {
-  _INFO << "Corpus:: reading development data from: " << filename;
-  BOOST_ASSERT_MSG(word_map.size() > 1,
-    "Corpus:: ROOT and UNK should be inserted before loading devel data.");
-
-  std::ifstream in(filename);
-  BOOST_ASSERT_MSG(in, "Corpus:: failed to open the devel file.");
-
-  n_devel = 0;
-  std::string data;
-  std::string line;
-  while (std::getline(in, line)) {
-    boost::algorithm::trim(line);
-    if (line.empty()) {
-      parse_data(data, devel_inputs[n_devel], devel_actions[n_devel], false);
-      data = "";
-      ++n_devel;
-    } else {
-      data += (line + "\n");
-    }
-  }
-  if (!data.empty()) {
-    parse_data(data, devel_inputs[n_devel], devel_actions[n_devel], false);
-    ++n_devel;
-  }
-  _INFO << "Corpus:: loaded " << n_devel << " development sentences.";
-}
-
-void Corpus::load_test_data(const std::string & filename) {
-  _INFO << "Corpus:: reading test data from: " << filename;
-  BOOST_ASSERT_MSG(word_map.size() > 1,
-                   "Corpus:: ROOT and UNK should be inserted before loading devel data.");
-
-  std::ifstream in(filename);
-  BOOST_ASSERT_MSG(in, "Corpus:: failed to open the test file.");
-
-  n_test = 0;
-  std::string data;
-  std::string line;
-  while (std::getline(in, line)) {
-    boost::algorithm::trim(line);
-    if (line.size() == 0) {
-      parse_data(data, test_inputs[n_test], test_actions[n_test], false);
-      data = "";
-      ++n_test;
-    } else {
-      data += (line + "\n");
-    }
-  }
-  if (!data.empty()) {
-    parse_data(data, test_inputs[n_test], test_actions[n_test], false);
-    ++n_test;
-  }
-  _INFO << "Corpus:: loaded " << n_test << " development sentences.";
-}
-
-void Corpus::parse_data(const std::string& data,
-                        InputUnits& input_units,
-                        ActionUnits& action_units,
-                        bool train) {
-  std::stringstream S(data);
-  std::string line;
-
-  input_units.clear();
-  action_units.clear();
-
-  while (std::getline(S, line)) {
-    std::vector<std::string> tokens;
-    boost::algorithm::trim(line);
-    boost::algorithm::split(tokens, line, boost::is_any_of(" \t"), boost::token_compress_on);
-
-    if (tokens[1] == "::tok") {
-      for (int i = 2; i < tokens.size(); i++) {
-        input_units.push_back(InputUnit());
-        if (train) {
-          unsigned wid = word_map.insert(tokens[i]);
-          input_units[i - 2].wid = wid;
-          input_units[i - 2].aux_wid = wid;
-          input_units[i - 2].w_str = tokens[i];
-          for (int j = 0; j < tokens[i].size(); ++j) {
-            unsigned c_id = char_map.insert(std::string(1, tokens[i][j]));
-            input_units[i - 2].c_id.push_back(c_id);
-          }
-        } else {
-          unsigned wid = (word_map.contains(tokens[i])) ? word_map.get(tokens[i]) : word_map.get(UNK);
-          input_units[i - 2].wid = wid;
-          input_units[i - 2].aux_wid = wid;
-          input_units[i - 2].w_str = tokens[i];
-          for (int j = 0; j < tokens[i].size(); ++j) {
-            unsigned c_id = (char_map.contains(std::string(1, tokens[i][j]))) ? char_map.get(std::string(1, tokens[i][j])) : char_map.get(UNK);
-            input_units[i - 2].c_id.push_back(c_id);
-          }
-        }
-      } 
-    } else if (tokens[1] == "::pos") {
-      for (int i = 2; i < tokens.size(); i++) {
-        if (train) {
-          unsigned pid = pos_map.insert(tokens[i]);
-          input_units[i - 2].pid = pid;
-        } else {
-          unsigned pid = (pos_map.contains(tokens[i])) ? pos_map.get(tokens[i]) : pos_map.get(UNK);
-          input_units[i - 2].pid = pid;
-        }
-      }
-    } else if (tokens[1] == "::action") {
-      std::string action = tokens[2];
-      for (int i = 3; i < tokens.size(); i++) {
-        action += "\t" + tokens[i];
-      }
-      ActionUnit action_unit = ActionUnit(action, tokens[2]);
-      if (tokens[2] == "CONFIRM") {
-        action_unit.action_name = "CONFIRM";
-      } else {
-        action_unit.action_name = action;
-      }
-
-      if (train) {
-        std::vector<std::string> terms;
-        boost::algorithm::split(terms, action, boost::is_any_of(" \t"), boost::token_compress_on);
-        if (terms[0] == "CONFIRM") {
-          unsigned wid = (word_map.contains(terms[1])) ? word_map.get(terms[1]) : word_map.get(UNK);
-          if (wid == word_map.get(UNK)) {
-            action_unit.idx = 0;
-          } else {
-            if (confirm_map.find(wid) == confirm_map.end()) {
-              confirm_map[wid] = Alphabet();
-              confirm_map[wid].insert(word_map.get(wid));
-            }
-            action_unit.idx = confirm_map[wid].insert(terms[2]);
-          }
-        } else if (terms[0] == "NEWNODE") {
-          unsigned nid = node_map.insert(terms[1]);
-          action_unit.idx = nid;
-        } else if (terms[0] == "LEFT" || terms[0] == "RIGHT") {
-          unsigned rid = rel_map.insert(terms[1]);
-          action_unit.idx = rid;
-        } else if (terms[0] == "ENTITY") {
-          unsigned eid = entity_map.insert(terms[1]);
-          action_unit.idx = eid;
-        }
-        unsigned aid = action_map.insert(action_unit.action_name);
-        action_unit.aid = aid;
-      } else {
-        unsigned aid = (action_map.contains(action_unit.action_name)) ? action_map.get(action_unit.action_name) : action_map.get(UNK);
-        action_unit.aid = aid;
-      }
-      action_units.push_back(action_unit);
-    }
-  }
-  InputUnit input_unit;
-  input_unit.wid = word_map.get(ROOT);
-  input_unit.pid = pos_map.get(ROOT);
-  input_unit.aux_wid = word_map.get(ROOT);
-  input_unit.w_str = ROOT;
-  input_units.push_back(input_unit);
-}
-
-unsigned Corpus::get_or_add_word(const std::string& word) {
-  return word_map.insert(word);
-}
-
-void Corpus::stat() {
-  _INFO << "Corpus:: # of words = " << word_map.size();
-  _INFO << "Corpus:: # of pos = " << pos_map.size();
-}
-
-void Corpus::get_vocabulary_and_singletons() {
-  std::map<unsigned, unsigned> counter;
-  for (auto& payload : training_inputs) {
-    for (auto& item : payload.second) {
-      vocab.insert(item.wid);
-      ++counter[item.wid];
-    }
-  }
-  for (auto& payload : counter) {
-    if (payload.second == 1) { singleton.insert(payload.first); }
-  }
-}
-
-void load_pretrained_word_embedding(const std::string& embedding_file,
-                                    unsigned pretrained_dim,
-                                    std::unordered_map<unsigned, std::vector<float> >& pretrained,
-                                    Corpus& corpus) {
-  pretrained[corpus.get_or_add_word(Corpus::BAD0)] = std::vector<float>(pretrained_dim, 0.f);
-  pretrained[corpus.get_or_add_word(Corpus::UNK)] = std::vector<float>(pretrained_dim, 0.f);
-  _INFO << "Main:: Loading from " << embedding_file << " with " << pretrained_dim << " dimensions.";
-  std::ifstream ifs(embedding_file);
-  BOOST_ASSERT_MSG(ifs, "Failed to load embedding file.");
-  std::string line;
-  // get the header in word2vec styled embedding.
-  std::getline(ifs, line);
-  std::vector<float> v(pretrained_dim, 0.);
-  std::string word;
-  while (std::getline(ifs, line)) {
-    std::istringstream iss(line);
-    iss >> word;
-    // actually, there should be a checking about the embedding dimension.
-    for (unsigned i = 0; i < pretrained_dim; ++i) { iss >> v[i]; }
-    unsigned id = corpus.get_or_add_word(word);
-    pretrained[id] = v;
-  }
-}
+#include "corpus.h"
+#include <iostream>
+#include <fstream>
+#include <deque>
+#include <thread>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <random>
+#include "logging.h"
+#include "sys_utils.h"
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/assert.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+
+const unsigned Corpus::CACHE_VERSION = 3;
+const unsigned Corpus::NO_CONCEPT = static_cast<unsigned>(-1);
+const char* Corpus::UNK  = "_UNK_";
+const char* Corpus::SPAN = "_SPAN_";
+const char* Corpus::BAD0 = "_BAD0_";
+const char* Corpus::ROOT = "_ROOT_";
+
+Corpus::Corpus() : n_train(0), n_devel(0) {
+
+}
+
+namespace {
+
+typedef boost::string_ref StringRef;
+
+bool is_space(char c) {
+  return std::isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+StringRef trim(StringRef s) {
+  while (!s.empty() && is_space(s.front())) { s.remove_prefix(1); }
+  while (!s.empty() && is_space(s.back())) { s.remove_suffix(1); }
+  return s;
+}
+
+/// Split the line on space and tab, the consecutive separators are compressed.
+void tokenize(StringRef line, std::vector<StringRef>& tokens) {
+  tokens.clear();
+  const char* p = line.data();
+  const char* end = line.data() + line.size();
+  while (p < end) {
+    while (p < end && (*p == ' ' || *p == '\t')) { ++p; }
+    const char* q = p;
+    while (q < end && *q != ' ' && *q != '\t') { ++q; }
+    if (q > p) { tokens.push_back(StringRef(p, q - p)); }
+    p = q;
+  }
+}
+
+/// Iterate the lines of a buffer without copying them.
+struct LineReader {
+  const char* p;
+  const char* end;
+
+  LineReader(StringRef buffer) : p(buffer.data()), end(buffer.data() + buffer.size()) {}
+
+  bool next(StringRef& line) {
+    if (p >= end) { return false; }
+    const char* q = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    if (q == nullptr) { q = end; }
+    line = StringRef(p, q - p);
+    p = (q < end ? q + 1 : end);
+    return true;
+  }
+};
+
+/// Find the blocks of the buffer. As the old line-by-line loader, every
+/// blank line closes a block, and the non-blank tail is the last block.
+void find_blocks(StringRef buffer, std::vector<StringRef>& blocks) {
+  LineReader reader(buffer);
+  StringRef line;
+  const char* start = buffer.data();
+  bool has_data = false;
+  while (reader.next(line)) {
+    if (trim(line).empty()) {
+      blocks.push_back(StringRef(start, line.data() - start));
+      start = reader.p;
+      has_data = false;
+    } else {
+      has_data = true;
+    }
+  }
+  if (has_data) { blocks.push_back(StringRef(start, buffer.data() + buffer.size() - start)); }
+}
+
+/// Join tokens[2:] with tab into the action string. The mapped buffer is
+/// reused when the action is already tab-separated, otherwise the joined
+/// string is kept in the arena.
+StringRef join_action(const std::vector<StringRef>& tokens, std::deque<std::string>& arena) {
+  bool contiguous = true;
+  for (unsigned i = 3; i < tokens.size() && contiguous; ++i) {
+    contiguous = (tokens[i].data() == tokens[i - 1].data() + tokens[i - 1].size() + 1 &&
+                  tokens[i - 1].data()[tokens[i - 1].size()] == '\t');
+  }
+  if (contiguous) {
+    return StringRef(tokens[2].data(),
+                     tokens.back().data() + tokens.back().size() - tokens[2].data());
+  }
+  arena.push_back(tokens[2].to_string());
+  for (unsigned i = 3; i < tokens.size(); ++i) {
+    arena.back() += '\t';
+    arena.back().append(tokens[i].data(), tokens[i].size());
+  }
+  return StringRef(arena.back());
+}
+
+/// The alphabet staged by one loading thread, ids are local to the thread.
+struct LocalAlphabet {
+  std::unordered_map<StringRef, unsigned, StringRefHash> str_to_id;
+  std::vector<StringRef> id_to_str;
+
+  unsigned insert(const StringRef& str) {
+    auto found = str_to_id.find(str);
+    if (found != str_to_id.end()) { return found->second; }
+    unsigned id = id_to_str.size();
+    str_to_id[str] = id;
+    id_to_str.push_back(str);
+    return id;
+  }
+
+  /// Insert the staged strings into the global alphabet in the order of
+  /// their first occurrences, return the local id to global id mapping.
+  std::vector<unsigned> merge_into(Alphabet& alphabet) const {
+    std::vector<unsigned> remap(id_to_str.size());
+    for (unsigned i = 0; i < id_to_str.size(); ++i) {
+      remap[i] = alphabet.insert(id_to_str[i]);
+    }
+    return remap;
+  }
+};
+
+/// The alphabet that the idx of an action points to.
+enum ActionIndexKind { kNoIndex, kNodeIndex, kRelIndex, kEntityIndex, kConfirmIndex };
+
+/// The pid of a staged word without the ::pos line.
+const unsigned kNoPos = static_cast<unsigned>(-1);
+
+/// The line position of a block, used to tell if a word has been seen
+/// before a CONFIRM action. 0 is for the words inserted before loading.
+uint64_t position(unsigned block, unsigned line) {
+  return ((static_cast<uint64_t>(block) + 1) << 32) | line;
+}
+
+struct PendingConfirm {
+  unsigned action;
+  uint64_t position;
+  StringRef word;
+  StringRef concept;
+};
+
+/// The units of a block in flat buffers, char_ends[j] is the end of the
+/// characters of token j in c_ids.
+struct ParsedBlock {
+  std::vector<unsigned> wids;
+  std::vector<unsigned> aux_wids;
+  std::vector<unsigned> pids;
+  std::vector<StringRef> surfaces;
+  std::vector<unsigned> char_ends;
+  std::vector<unsigned> c_ids;
+  std::vector<unsigned> aids;
+  std::vector<unsigned> idxs;
+  std::vector<unsigned char> kinds;
+  std::vector<PendingConfirm> confirms;
+};
+
+/// The per-thread staging area for the training data.
+struct Staging {
+  LocalAlphabet words;
+  LocalAlphabet pos;
+  LocalAlphabet actions;
+  LocalAlphabet nodes;
+  LocalAlphabet rels;
+  LocalAlphabet entities;
+  std::vector<uint64_t> word_positions;  // local word id -> first position.
+  std::vector<unsigned char> chars;      // the bytes in first-occurrence order.
+  bool seen_chars[256];
+  std::deque<std::string> arena;
+
+  Staging() { std::fill(seen_chars, seen_chars + 256, false); }
+};
+
+/// Parse a block. With staging, the strings are staged into the thread-local
+/// alphabets (the training data); without it, they are looked up in the
+/// corpus alphabets read-only, and char_ids caches the id for each byte.
+/// With resolve_idxs, the idx of a looked-up action is resolved as in the
+/// training data (CONFIRM in the confirm alphabet of the word, NO_CONCEPT if
+/// it is not there), otherwise it is 0.
+void parse_block(const Corpus& corpus,
+                 StringRef block,
+                 unsigned block_id,
+                 Staging* staging,
+                 const unsigned* char_ids,
+                 ParsedBlock& out,
+                 bool resolve_idxs = false) {
+  const unsigned unk_wid = corpus.word_map.get(Corpus::UNK);
+  std::vector<StringRef> tokens;
+  std::deque<std::string> local_arena;
+  LineReader reader(block);
+  StringRef line;
+  unsigned line_id = 0;
+  while (reader.next(line)) {
+    ++line_id;
+    tokenize(trim(line), tokens);
+    if (tokens.size() < 2) { continue; }
+
+    if (tokens[1] == "::tok") {
+      for (unsigned i = 2; i < tokens.size(); ++i) {
+        out.surfaces.push_back(tokens[i]);
+        if (staging) {
+          unsigned n_words = staging->words.id_to_str.size();
+          unsigned wid = staging->words.insert(tokens[i]);
+          if (wid == n_words) { staging->word_positions.push_back(position(block_id, line_id)); }
+          out.wids.push_back(wid);
+          out.aux_wids.push_back(wid);
+          out.pids.push_back(kNoPos);
+          for (char c : tokens[i]) {
+            unsigned char b = static_cast<unsigned char>(c);
+            if (!staging->seen_chars[b]) { staging->seen_chars[b] = true; staging->chars.push_back(b); }
+            out.c_ids.push_back(b);
+          }
+        } else {
+          unsigned aux_wid = (corpus.word_map.contains(tokens[i]) ? corpus.word_map.get(tokens[i]) : unk_wid);
+          out.wids.push_back(corpus.vocab.count(aux_wid) ? aux_wid : unk_wid);
+          out.aux_wids.push_back(aux_wid);
+          out.pids.push_back(0);
+          for (char c : tokens[i]) { out.c_ids.push_back(char_ids[static_cast<unsigned char>(c)]); }
+        }
+        out.char_ends.push_back(out.c_ids.size());
+      }
+    } else if (tokens[1] == "::pos") {
+      for (unsigned i = 2; i < tokens.size() && i - 2 < out.pids.size(); ++i) {
+        if (staging) {
+          out.pids[i - 2] = staging->pos.insert(tokens[i]);
+        } else {
+          out.pids[i - 2] = (corpus.pos_map.contains(tokens[i]) ?
+                             corpus.pos_map.get(tokens[i]) : corpus.pos_map.get(Corpus::UNK));
+        }
+      }
+    } else if (tokens[1] == "::action" && tokens.size() > 2) {
+      bool is_confirm = (tokens[2] == "CONFIRM");
+      StringRef action_name = (is_confirm ? StringRef("CONFIRM") :
+                               join_action(tokens, staging ? staging->arena : local_arena));
+      unsigned idx = 0;
+      if (staging) {
+        unsigned char kind = kNoIndex;
+        if (is_confirm) {
+          BOOST_ASSERT_MSG(tokens.size() > 4, "Corpus:: CONFIRM should be followed by the word and the concept.");
+          kind = kConfirmIndex;
+          PendingConfirm pending;
+          pending.action = out.aids.size();
+          pending.position = position(block_id, line_id);
+          pending.word = tokens[3];
+          pending.concept = tokens[4];
+          out.confirms.push_back(pending);
+        } else if (tokens[2] == "NEWNODE" && tokens.size() > 3) {
+          kind = kNodeIndex;
+          idx = staging->nodes.insert(tokens[3]);
+        } else if ((tokens[2] == "LEFT" || tokens[2] == "RIGHT") && tokens.size() > 3) {
+          kind = kRelIndex;
+          idx = staging->rels.insert(tokens[3]);
+        } else if (tokens[2] == "ENTITY" && tokens.size() > 3) {
+          kind = kEntityIndex;
+          idx = staging->entities.insert(tokens[3]);
+        }
+        out.kinds.push_back(kind);
+        out.aids.push_back(staging->actions.insert(action_name));
+      } else {
+        if (resolve_idxs) {
+          const Alphabet* alphabet = nullptr;
+          if (is_confirm) {
+            idx = Corpus::NO_CONCEPT;
+            if (tokens.size() > 4 && corpus.word_map.contains(tokens[3])) {
+              auto found = corpus.confirm_map.find(corpus.word_map.get(tokens[3]));
+              if (found != corpus.confirm_map.end() && found->second.contains(tokens[4])) {
+                idx = found->second.get(tokens[4]);
+              }
+            }
+          } else if (tokens[2] == "NEWNODE" && tokens.size() > 3) {
+            alphabet = &corpus.node_map;
+          } else if ((tokens[2] == "LEFT" || tokens[2] == "RIGHT") && tokens.size() > 3) {
+            alphabet = &corpus.rel_map;
+          } else if (tokens[2] == "ENTITY" && tokens.size() > 3) {
+            alphabet = &corpus.entity_map;
+          }
+          if (alphabet != nullptr && alphabet->contains(tokens[3])) { idx = alphabet->get(tokens[3]); }
+        }
+        out.aids.push_back(corpus.action_map.contains(action_name) ?
+                           corpus.action_map.get(action_name) : corpus.action_map.get(Corpus::UNK));
+      }
+      out.idxs.push_back(idx);
+    }
+  }
+}
+
+/// Append the ROOT token and the block to the buffers of the split.
+void append_block(const Corpus& corpus,
+                  const ParsedBlock& block,
+                  InputBuffer& inputs,
+                  ActionBuffer& actions) {
+  unsigned char_base = inputs.c_ids.size();
+  for (unsigned j = 0; j < block.wids.size(); ++j) {
+    inputs.surface_ids.push_back(inputs.surfaces.insert(block.surfaces[j]));
+    inputs.char_offsets.push_back(char_base + block.char_ends[j]);
+  }
+  inputs.wids.insert(inputs.wids.end(), block.wids.begin(), block.wids.end());
+  inputs.aux_wids.insert(inputs.aux_wids.end(), block.aux_wids.begin(), block.aux_wids.end());
+  inputs.pids.insert(inputs.pids.end(), block.pids.begin(), block.pids.end());
+  inputs.c_ids.insert(inputs.c_ids.end(), block.c_ids.begin(), block.c_ids.end());
+
+  inputs.wids.push_back(corpus.word_map.get(Corpus::ROOT));
+  inputs.aux_wids.push_back(corpus.word_map.get(Corpus::ROOT));
+  inputs.pids.push_back(corpus.pos_map.get(Corpus::ROOT));
+  inputs.surface_ids.push_back(inputs.surfaces.insert(Corpus::ROOT));
+  inputs.char_offsets.push_back(inputs.c_ids.size());
+  inputs.offsets.push_back(inputs.wids.size());
+
+  actions.aids.insert(actions.aids.end(), block.aids.begin(), block.aids.end());
+  actions.idxs.insert(actions.idxs.end(), block.idxs.begin(), block.idxs.end());
+  actions.offsets.push_back(actions.aids.size());
+}
+
+/// FNV-1a hash of the file content, the cache is invalidated when it changes.
+uint64_t hash_file(const std::string& filename, uint64_t& size) {
+  MappedFile file;
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(file.open(filename));
+  size = file.size();
+  uint64_t hash = 14695981039346656037ULL;
+  for (uint64_t i = 0; i < size; ++i) {
+    hash ^= p[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+/// Renumber the alphabet by descending count, ties are kept in the order
+/// of the old ids and the first n_pinned ids keep their places. Return the
+/// old id to new id mapping.
+std::vector<unsigned> sort_alphabet(Alphabet& alphabet,
+                                    const std::vector<unsigned>& counts,
+                                    unsigned n_pinned) {
+  std::vector<unsigned> order(alphabet.size());
+  for (unsigned i = 0; i < order.size(); ++i) { order[i] = i; }
+  n_pinned = std::min<unsigned>(n_pinned, order.size());
+  std::stable_sort(order.begin() + n_pinned, order.end(),
+                   [&counts](unsigned a, unsigned b) { return counts[a] > counts[b]; });
+
+  Alphabet sorted;
+  std::vector<unsigned> remap(order.size());
+  for (unsigned i = 0; i < order.size(); ++i) {
+    remap[order[i]] = sorted.insert(alphabet.get(order[i]));
+  }
+  sorted.freezed = alphabet.freezed;
+  alphabet = std::move(sorted);
+  return remap;
+}
+
+unsigned get_n_threads(unsigned n_blocks) {
+  unsigned n_threads = std::thread::hardware_concurrency();
+  if (n_threads == 0) { n_threads = 1; }
+  return std::max(1u, std::min(n_threads, n_blocks));
+}
+
+/// Run func(thread_id, begin, end) over the contiguous chunks of [0, n).
+template <class Function>
+void parallel_for(unsigned n, unsigned n_threads, Function func) {
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < n_threads; ++t) {
+    unsigned begin = static_cast<unsigned>(static_cast<uint64_t>(n) * t / n_threads);
+    unsigned end = static_cast<unsigned>(static_cast<uint64_t>(n) * (t + 1) / n_threads);
+    threads.push_back(std::thread(func, t, begin, end));
+  }
+  for (std::thread& thread : threads) { thread.join(); }
+}
+
+/// The char id of every byte, UNK for the bytes out of the char alphabet.
+void get_char_ids(const Corpus& corpus, unsigned* char_ids) {
+  for (unsigned c = 0; c < 256; ++c) {
+    std::string ch(1, static_cast<char>(c));
+    char_ids[c] = (corpus.char_map.contains(ch) ? corpus.char_map.get(ch) : corpus.char_map.get(Corpus::UNK));
+  }
+}
+
+/// The number of blocks parsed at once when the data is streamed.
+const unsigned kStreamChunkSize = 4096;
+
+/// Insert the symbols that every training corpus starts with.
+void add_special_symbols(Corpus& corpus) {
+  corpus.word_map.insert(Corpus::ROOT);
+  corpus.word_map.insert(Corpus::UNK);
+  // word_map.insert(Corpus::SPAN);
+  corpus.pos_map.insert(Corpus::ROOT);
+  corpus.pos_map.insert(Corpus::UNK);
+  corpus.char_map.insert(Corpus::UNK);
+  corpus.action_map.insert("CONFIRM");
+  corpus.action_map.insert(Corpus::UNK);
+
+  corpus.confirm_map[corpus.word_map.get(Corpus::UNK)] = Alphabet();
+  corpus.confirm_map[corpus.word_map.get(Corpus::UNK)].insert(Corpus::UNK);
+}
+
+/// Parse the training blocks and insert their strings into the corpus
+/// alphabets, the parsed blocks hold the global ids. The words inserted
+/// before the call count as seen before all the blocks, so a file can be
+/// parsed in consecutive chunks with the same ids as a single call.
+void parse_training_blocks(Corpus& corpus,
+                           const std::vector<StringRef>& blocks,
+                           std::vector<ParsedBlock>& parsed) {
+  // Phase 1: parse the blocks into the per-thread staging alphabets.
+  unsigned n_threads = get_n_threads(blocks.size());
+  parsed.assign(blocks.size(), ParsedBlock());
+  std::vector<Staging> stagings(n_threads);
+  parallel_for(blocks.size(), n_threads, [&](unsigned t, unsigned begin, unsigned end) {
+    for (unsigned i = begin; i < end; ++i) {
+      parse_block(corpus, blocks[i], i, &stagings[t], nullptr, parsed[i]);
+    }
+  });
+
+  // Phase 2: merge the staged alphabets in the order of the threads, which
+  // gives the same ids as loading the file sequentially.
+  struct Remap {
+    std::vector<unsigned> words, pos, actions, nodes, rels, entities;
+    unsigned chars[256];
+  };
+  std::vector<Remap> remaps(n_threads);
+  std::vector<uint64_t> word_positions(corpus.word_map.size(), 0);
+  for (unsigned t = 0; t < n_threads; ++t) {
+    const Staging& staging = stagings[t];
+    Remap& remap = remaps[t];
+    remap.words = staging.words.merge_into(corpus.word_map);
+    for (unsigned i = 0; i < remap.words.size(); ++i) {
+      if (remap.words[i] == word_positions.size()) { word_positions.push_back(staging.word_positions[i]); }
+    }
+    remap.pos = staging.pos.merge_into(corpus.pos_map);
+    remap.actions = staging.actions.merge_into(corpus.action_map);
+    remap.nodes = staging.nodes.merge_into(corpus.node_map);
+    remap.rels = staging.rels.merge_into(corpus.rel_map);
+    remap.entities = staging.entities.merge_into(corpus.entity_map);
+    for (unsigned char c : staging.chars) { remap.chars[c] = corpus.char_map.insert(std::string(1, c)); }
+  }
+
+  // Phase 3: translate the local ids into the global ids.
+  parallel_for(blocks.size(), n_threads, [&](unsigned t, unsigned begin, unsigned end) {
+    const Remap& remap = remaps[t];
+    for (unsigned i = begin; i < end; ++i) {
+      ParsedBlock& block = parsed[i];
+      for (unsigned j = 0; j < block.wids.size(); ++j) {
+        block.wids[j] = block.aux_wids[j] = remap.words[block.wids[j]];
+        block.pids[j] = (block.pids[j] == kNoPos ? 0 : remap.pos[block.pids[j]]);
+      }
+      for (unsigned& c_id : block.c_ids) { c_id = remap.chars[c_id]; }
+      for (unsigned j = 0; j < block.aids.size(); ++j) {
+        block.aids[j] = remap.actions[block.aids[j]];
+        switch (block.kinds[j]) {
+        case kNodeIndex: block.idxs[j] = remap.nodes[block.idxs[j]]; break;
+        case kRelIndex: block.idxs[j] = remap.rels[block.idxs[j]]; break;
+        case kEntityIndex: block.idxs[j] = remap.entities[block.idxs[j]]; break;
+        default: break;
+        }
+      }
+    }
+  });
+
+  // Phase 4: resolve the CONFIRM actions in the file order. The word is known
+  // only if it first occurs before the action, as in the sequential loader.
+  const unsigned unk_wid = corpus.word_map.get(Corpus::UNK);
+  for (ParsedBlock& block : parsed) {
+    for (const PendingConfirm& pending : block.confirms) {
+      unsigned wid = unk_wid;
+      if (corpus.word_map.contains(pending.word)) {
+        unsigned found = corpus.word_map.get(pending.word);
+        if (word_positions[found] < pending.position) { wid = found; }
+      }
+      unsigned& idx = block.idxs[pending.action];
+      if (wid == unk_wid) {
+        idx = 0;
+      } else {
+        if (corpus.confirm_map.find(wid) == corpus.confirm_map.end()) {
+          corpus.confirm_map[wid] = Alphabet();
+          corpus.confirm_map[wid].insert(corpus.word_map.get(wid));
+        }
+        idx = corpus.confirm_map[wid].insert(pending.concept);
+      }
+    }
+  }
+}
+
+}
+
+void Corpus::load_training_data(const std::string& filename, bool use_cache) {
+  _INFO << "Corpus:: reading training data from: " << filename;
+  if (use_cache && load_training_cache(filename)) { return; }
+
+  add_special_symbols((*this));
+
+  training_inputs.clear();
+  training_actions.clear();
+  ChunkReader reader;
+  reader.open(filename, ChunkReader::kBlock);
+  const char* data;
+  size_t size;
+  std::vector<StringRef> blocks;
+  std::vector<ParsedBlock> parsed;
+  while (reader.next(data, size)) {
+    blocks.clear();
+    find_blocks(StringRef(data, size), blocks);
+    parse_training_blocks((*this), blocks, parsed);
+    for (const ParsedBlock& block : parsed) { append_block((*this), block, training_inputs, training_actions); }
+  }
+  n_train = training_inputs.size();
+  _INFO << "Corpus:: loaded " << n_train << " training sentences.";
+  if (use_cache) { save_training_cache(filename); }
+}
+
+void Corpus::scan_training_data(const std::vector<std::string>& filenames) {
+  add_special_symbols((*this));
+
+  std::vector<unsigned> counter;
+  const unsigned root_wid = word_map.get(Corpus::ROOT);
+  n_train = 0;
+  for (const std::string& filename : filenames) {
+    _INFO << "Corpus:: scanning training data from: " << filename;
+    ChunkReader reader;
+    reader.open(filename, ChunkReader::kBlock);
+    const char* data;
+    size_t size;
+    std::vector<StringRef> blocks;
+    std::vector<ParsedBlock> parsed;
+    while (reader.next(data, size)) {
+      blocks.clear();
+      find_blocks(StringRef(data, size), blocks);
+      for (unsigned begin = 0; begin < blocks.size(); begin += kStreamChunkSize) {
+        unsigned end = std::min<unsigned>(begin + kStreamChunkSize, blocks.size());
+        std::vector<StringRef> chunk(blocks.begin() + begin, blocks.begin() + end);
+        parse_training_blocks((*this), chunk, parsed);
+        counter.resize(word_map.size(), 0);
+        for (const ParsedBlock& block : parsed) {
+          for (unsigned wid : block.wids) { ++counter[wid]; }
+          ++counter[root_wid];
+        }
+        n_train += parsed.size();
+      }
+    }
+  }
+  training_inputs.clear();
+  training_actions.clear();
+  set_vocabulary_and_singletons(counter);
+  _INFO << "Corpus:: scanned " << n_train << " training sentences in " << filenames.size() << " shards.";
+}
+
+bool Corpus::load_training_cache(const std::string& filename) {
+  std::string cache_file = filename + ".cache";
+  std::ifstream ifs(cache_file, std::ios::binary);
+  if (!ifs) { return false; }
+
+  uint64_t size;
+  uint64_t hash = hash_file(filename, size);
+  // read into a temporary corpus, a truncated cache leaves this one untouched.
+  Corpus cached;
+  try {
+    boost::archive::binary_iarchive ia(ifs);
+    unsigned cached_version;
+    uint64_t cached_size, cached_hash;
+    ia >> cached_version >> cached_size >> cached_hash;
+    if (cached_version != CACHE_VERSION || cached_size != size || cached_hash != hash) {
+      _INFO << "Corpus:: " << cache_file << " is stale, re-parse the training data.";
+      return false;
+    }
+    ia >> cached;
+  } catch (const std::exception& e) {
+    // besides archive_exception, a corrupted length throws bad_alloc or length_error.
+    _WARN << "Corpus:: failed to read " << cache_file << ": " << e.what();
+    return false;
+  }
+  n_train = cached.n_train;
+  word_map = std::move(cached.word_map);
+  pos_map = std::move(cached.pos_map);
+  action_map = std::move(cached.action_map);
+  char_map = std::move(cached.char_map);
+  node_map = std::move(cached.node_map);
+  rel_map = std::move(cached.rel_map);
+  entity_map = std::move(cached.entity_map);
+  confirm_map = std::move(cached.confirm_map);
+  training_inputs = std::move(cached.training_inputs);
+  training_actions = std::move(cached.training_actions);
+  vocab = std::move(cached.vocab);
+  singleton = std::move(cached.singleton);
+  _INFO << "Corpus:: loaded " << n_train << " training sentences from " << cache_file;
+  return true;
+}
+
+void Corpus::save_training_cache(const std::string& filename) {
+  get_vocabulary_and_singletons();
+
+  uint64_t size;
+  uint64_t hash = hash_file(filename, size);
+  std::string cache_file = filename + ".cache";
+  std::string tmp_file = cache_file + ".tmp." + boost::lexical_cast<std::string>(portable_getpid());
+  {
+    std::ofstream ofs(tmp_file, std::ios::binary);
+    if (!ofs) {
+      _WARN << "Corpus:: failed to write " << tmp_file << ", the training data is not cached.";
+      return;
+    }
+    boost::archive::binary_oarchive oa(ofs);
+    oa << CACHE_VERSION << size << hash;
+    oa << (*this);
+  }
+  if (std::rename(tmp_file.c_str(), cache_file.c_str()) != 0) {
+    _WARN << "Corpus:: failed to rename " << tmp_file << " to " << cache_file;
+    std::remove(tmp_file.c_str());
+    return;
+  }
+  _INFO << "Corpus:: cached the training data in " << cache_file;
+}
+
+unsigned Corpus::load_data(const std::string& filename,
+                           InputBuffer& inputs,
+                           ActionBuffer& actions) const {
+  unsigned char_ids[256];
+  get_char_ids((*this), char_ids);
+
+  inputs.clear();
+  actions.clear();
+  ChunkReader reader;
+  reader.open(filename, ChunkReader::kBlock);
+  const char* data;
+  size_t size;
+  std::vector<StringRef> blocks;
+  while (reader.next(data, size)) {
+    blocks.clear();
+    find_blocks(StringRef(data, size), blocks);
+    std::vector<ParsedBlock> parsed(blocks.size());
+    parallel_for(blocks.size(), get_n_threads(blocks.size()), [&](unsigned t, unsigned begin, unsigned end) {
+      for (unsigned i = begin; i < end; ++i) {
+        parse_block((*this), blocks[i], i, nullptr, char_ids, parsed[i], true);
+      }
+    });
+    for (const ParsedBlock& block : parsed) { append_block((*this), block, inputs, actions); }
+  }
+  return inputs.size();
+}
+
+void Corpus::load_devel_data(const std::string& filename) {
+  _INFO << "Corpus:: reading development data from: " << filename;
+  BOOST_ASSERT_MSG(word_map.size() > 1,
+    "Corpus:: ROOT and UNK should be inserted before loading devel data.");
+
+  BOOST_ASSERT_MSG(vocab.size() > 0,
+    "Corpus:: the vocabulary should be collected before loading devel data.");
+  n_devel = load_data(filename, devel_inputs, devel_actions);
+  _INFO << "Corpus:: loaded " << n_devel << " development sentences.";
+}
+
+void Corpus::load_test_data(const std::string & filename) {
+  _INFO << "Corpus:: reading test data from: " << filename;
+  BOOST_ASSERT_MSG(word_map.size() > 1,
+                   "Corpus:: ROOT and UNK should be inserted before loading test data.");
+
+  BOOST_ASSERT_MSG(vocab.size() > 0,
+                   "Corpus:: the vocabulary should be collected before loading test data.");
+  n_test = load_data(filename, test_inputs, test_actions);
+  _INFO << "Corpus:: loaded " << n_test << " test sentences.";
+}
+
+unsigned Corpus::get_or_add_word(const std::string& word) {
+  return word_map.insert(word);
+}
+
+void Corpus::collect_words(std::unordered_set<std::string>& words) const {
+  for (const std::string& word : word_map.id_to_str) { words.insert(word); }
+}
+
+void Corpus::collect_words(const std::string& filename,
+                           std::unordered_set<std::string>& words) const {
+  ChunkReader chunks;
+  chunks.open(filename, ChunkReader::kLine);
+  const char* data;
+  size_t size;
+  StringRef line;
+  std::vector<StringRef> tokens;
+  while (chunks.next(data, size)) {
+    LineReader reader(StringRef(data, size));
+    while (reader.next(line)) {
+      tokenize(trim(line), tokens);
+      if (tokens.size() < 2 || tokens[1] != "::tok") { continue; }
+      for (unsigned i = 2; i < tokens.size(); ++i) { words.insert(tokens[i].to_string()); }
+    }
+  }
+}
+
+void Corpus::sort_alphabets() {
+  std::vector<unsigned> word_counts(word_map.size(), 0);
+  std::vector<unsigned> char_counts(char_map.size(), 0);
+  std::vector<unsigned> action_counts(action_map.size(), 0);
+  std::vector<unsigned> node_counts(node_map.size(), 0);
+  std::vector<bool> is_newnode(action_map.size(), false);
+  for (unsigned aid = 0; aid < action_map.size(); ++aid) {
+    is_newnode[aid] = boost::algorithm::starts_with(action_map.get(aid), "NEWNODE");
+  }
+  for (unsigned wid : training_inputs.wids) { ++word_counts[wid]; }
+  for (unsigned c_id : training_inputs.c_ids) { ++char_counts[c_id]; }
+  for (unsigned j = 0; j < training_actions.aids.size(); ++j) {
+    unsigned aid = training_actions.aids[j];
+    ++action_counts[aid];
+    if (is_newnode[aid]) { ++node_counts[training_actions.idxs[j]]; }
+  }
+
+  // ROOT, UNK for word; UNK for char; CONFIRM, UNK for action.
+  std::vector<unsigned> word_remap = sort_alphabet(word_map, word_counts, 2);
+  std::vector<unsigned> char_remap = sort_alphabet(char_map, char_counts, 1);
+  std::vector<unsigned> action_remap = sort_alphabet(action_map, action_counts, 2);
+  std::vector<unsigned> node_remap = sort_alphabet(node_map, node_counts, 0);
+
+  for (unsigned& wid : training_inputs.wids) { wid = word_remap[wid]; }
+  for (unsigned& aux_wid : training_inputs.aux_wids) { aux_wid = word_remap[aux_wid]; }
+  for (unsigned& c_id : training_inputs.c_ids) { c_id = char_remap[c_id]; }
+  for (unsigned j = 0; j < training_actions.aids.size(); ++j) {
+    unsigned& aid = training_actions.aids[j];
+    if (is_newnode[aid]) { training_actions.idxs[j] = node_remap[training_actions.idxs[j]]; }
+    aid = action_remap[aid];
+  }
+
+  std::unordered_map<unsigned, Alphabet> sorted_confirm_map;
+  for (auto& payload : confirm_map) {
+    sorted_confirm_map[word_remap[payload.first]] = std::move(payload.second);
+  }
+  confirm_map = std::move(sorted_confirm_map);
+  get_vocabulary_and_singletons();
+  _INFO << "Corpus:: sorted the word, char, node and action alphabets by frequency.";
+}
+
+void Corpus::freeze() {
+  word_map.freeze();
+  pos_map.freeze();
+  action_map.freeze();
+  char_map.freeze();
+  node_map.freeze();
+  rel_map.freeze();
+  entity_map.freeze();
+  for (auto& payload : confirm_map) { payload.second.freeze(); }
+}
+
+void Corpus::stat() {
+  _INFO << "Corpus:: # of words = " << word_map.size();
+  _INFO << "Corpus:: # of pos = " << pos_map.size();
+}
+
+void Corpus::get_vocabulary_and_singletons() {
+  std::vector<unsigned> counter(word_map.size(), 0);
+  for (unsigned wid : training_inputs.wids) { ++counter[wid]; }
+  set_vocabulary_and_singletons(counter);
+}
+
+void Corpus::set_vocabulary_and_singletons(const std::vector<unsigned>& counter) {
+  vocab.clear();
+  singleton.clear();
+  for (unsigned wid = 0; wid < counter.size(); ++wid) {
+    if (counter[wid] > 0) { vocab.insert(wid); }
+    if (counter[wid] == 1) { singleton.insert(wid); }
+  }
+}
+
+TrainingStream::TrainingStream(const Corpus& corpus,
+                               const std::vector<std::string>& filenames,
+                               unsigned buffer_size) :
+  corpus(corpus),
+  filenames(filenames),
+  buffer_size(std::max(1u, buffer_size)),
+  n_filled(0),
+  shard(0),
+  in_shard(false),
+  block_next(0),
+  chunk_next(0) {
+  BOOST_ASSERT_MSG(!filenames.empty(), "TrainingStream:: no training shards.");
+  get_char_ids(corpus, char_ids);
+  for (unsigned i = 0; i < filenames.size(); ++i) { shard_order.push_back(i); }
+  // the surface_ids of a returned sentence are its aux_wids, word_map is
+  // referred to rather than copied.
+  current_inputs.shared_surfaces = &corpus.word_map;
+  current_inputs.offsets.assign(2, 0);
+  current_actions.offsets.assign(2, 0);
+}
+
+void TrainingStream::reset(std::mt19937& rng) {
+  std::shuffle(shard_order.begin(), shard_order.end(), rng);
+  reader.close();
+  in_shard = false;
+  blocks.clear();
+  chunk.clear();
+  n_filled = 0;
+  shard = 0;
+  block_next = 0;
+  chunk_next = 0;
+}
+
+bool TrainingStream::next(std::mt19937& rng, InputUnits& input_units, ActionUnits& action_units) {
+  while (n_filled < buffer_size) {
+    if (slots.size() <= n_filled) { slots.push_back(Slot()); }
+    if (!read(slots[n_filled])) { break; }
+    ++n_filled;
+  }
+  if (n_filled == 0) { return false; }
+
+  unsigned i = std::uniform_int_distribution<unsigned>(0, n_filled - 1)(rng);
+  hand_out(slots[i]);
+  if (!read(slots[i])) {
+    std::swap(slots[i], slots[n_filled - 1]);
+    --n_filled;
+  }
+  input_units = current_inputs[0];
+  action_units = current_actions[0];
+  return true;
+}
+
+bool TrainingStream::read(Slot& slot) {
+  while (chunk_next >= chunk.size()) {
+    if (!read_chunk()) { return false; }
+  }
+  std::swap(slot, chunk[chunk_next]);
+  ++chunk_next;
+  return true;
+}
+
+void TrainingStream::hand_out(Slot& slot) {
+  current_inputs.wids.swap(slot.wids);
+  current_inputs.aux_wids.swap(slot.aux_wids);
+  current_inputs.pids.swap(slot.pids);
+  current_inputs.char_offsets.swap(slot.char_offsets);
+  current_inputs.c_ids.swap(slot.c_ids);
+  current_inputs.surface_ids.assign(current_inputs.aux_wids.begin(), current_inputs.aux_wids.end());
+  current_inputs.offsets[1] = current_inputs.wids.size();
+
+  current_actions.aids.swap(slot.aids);
+  current_actions.idxs.swap(slot.idxs);
+  current_actions.offsets[1] = current_actions.aids.size();
+}
+
+bool TrainingStream::read_chunk() {
+  while (block_next >= blocks.size()) {
+    blocks.clear();
+    block_next = 0;
+    const char* data;
+    size_t size;
+    if (in_shard && reader.next(data, size)) {
+      find_blocks(StringRef(data, size), blocks);
+      continue;
+    }
+    reader.close();
+    in_shard = false;
+    if (shard >= filenames.size()) { return false; }
+    const std::string& filename = filenames[shard_order[shard++]];
+    _INFO << "TrainingStream:: streaming training data from: " << filename;
+    reader.open(filename, ChunkReader::kBlock);
+    in_shard = true;
+  }
+
+  unsigned n = std::min<unsigned>(kStreamChunkSize, blocks.size() - block_next);
+  std::vector<ParsedBlock> parsed(n);
+  parallel_for(n, get_n_threads(n), [&](unsigned t, unsigned begin, unsigned end) {
+    for (unsigned i = begin; i < end; ++i) {
+      parse_block(corpus, blocks[block_next + i], i, nullptr, char_ids, parsed[i], true);
+    }
+  });
+  block_next += n;
+
+  const unsigned root_wid = corpus.word_map.get(Corpus::ROOT);
+  const unsigned root_pid = corpus.pos_map.get(Corpus::ROOT);
+  chunk.resize(n);
+  for (unsigned i = 0; i < n; ++i) {
+    ParsedBlock& block = parsed[i];
+    Slot& slot = chunk[i];
+    slot.wids = std::move(block.wids);
+    slot.aux_wids = std::move(block.aux_wids);
+    slot.pids = std::move(block.pids);
+    slot.c_ids = std::move(block.c_ids);
+    slot.char_offsets.assign(1, 0);
+    slot.char_offsets.insert(slot.char_offsets.end(), block.char_ends.begin(), block.char_ends.end());
+    slot.aids = std::move(block.aids);
+    slot.idxs = std::move(block.idxs);
+    // the loss needs a concept, an unresolved CONFIRM gets 0 as in the loader.
+    for (unsigned& idx : slot.idxs) { if (idx == Corpus::NO_CONCEPT) { idx = 0; } }
+
+    slot.wids.push_back(root_wid);
+    slot.aux_wids.push_back(root_wid);
+    slot.pids.push_back(root_pid);
+    slot.char_offsets.push_back(slot.c_ids.size());
+  }
+  chunk_next = 0;
+  return true;
+}
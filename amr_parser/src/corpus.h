@@ -1,100 +1,360 @@
-#ifndef RLPARSER_CORPUS_H
-#define RLPARSER_CORPUS_H
-
-#include <unordered_map>
-#include <vector>
-#include <set>
-#include "ds.h"
-#include <boost/serialization/vector.hpp>
-
-struct InputUnit {
-  unsigned wid;
-  unsigned aux_wid;
-  unsigned pid;
-  std::vector<unsigned> c_id;
-
-  std::string w_str;
-
-  friend class boost::serialization::access;
-  template <class Archive>
-  void serialize(Archive& ar, const unsigned version) {
-    ar & wid;
-    ar & pid;
-    ar & c_id;
-    ar & aux_wid;
-  }
-};
-
-struct ActionUnit {
-  std::string a_str;
-  std::string action_name;
-  unsigned aid;
-  unsigned idx; //for confirm, newnode, la and ra op
-
-  ActionUnit(std::string a_str, std::string action_name): a_str(a_str), action_name(action_name){}
-  friend class boost::serialization::access;
-  template <class Archive>
-  void serialize(Archive& ar, const unsigned version) {
-    ar & aid;
-    ar & idx;
-  }
-};
-
-typedef std::vector<InputUnit> InputUnits;
-typedef std::vector<ActionUnit> ActionUnits;
-
-struct Corpus {
-  const static char* UNK;
-  const static char* SPAN;
-  const static char* BAD0;
-  const static char* ROOT;
-
-  unsigned n_train;
-  unsigned n_devel;
-  unsigned n_test;
-
-  Alphabet word_map;
-  Alphabet pos_map;
-  Alphabet action_map;
-  Alphabet char_map;
-  Alphabet node_map;
-  Alphabet rel_map;
-  Alphabet entity_map;
-
-  std::unordered_map<unsigned, Alphabet> confirm_map;
-
-  std::unordered_map<unsigned, InputUnits> training_inputs;
-  std::unordered_map<unsigned, ActionUnits> training_actions;
-  std::unordered_map<unsigned, InputUnits> devel_inputs;
-  std::unordered_map<unsigned, ActionUnits> devel_actions;
-  std::unordered_map<unsigned, InputUnits> test_inputs;
-  std::unordered_map<unsigned, ActionUnits> test_actions;
-
-  std::set<unsigned> vocab;
-  std::set<unsigned> singleton;
-  
-  Corpus();
-
-  void load_training_data(const std::string& filename);
-
-  void load_devel_data(const std::string& filename);
-
-  void load_test_data(const std::string& filename);
-
-  void parse_data(const std::string& data,
-                  InputUnits& input_units, 
-                  ActionUnits& action_units,
-                  bool train);
- 
-  void get_vocabulary_and_singletons();
-
-  unsigned get_or_add_word(const std::string& word);
-  void stat();
-};
-
-void load_pretrained_word_embedding(const std::string& embedding_file,
-                                    unsigned pretrained_dim,
-                                    std::unordered_map<unsigned, std::vector<float> >& pretrained,
-                                    Corpus& corpus);
-
-#endif  //  end for RLPARSER_CORPUS_H
+#ifndef RLPARSER_CORPUS_H
+#define RLPARSER_CORPUS_H
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <random>
+#include "ds.h"
+#include "sys_utils.h"
+#include <boost/serialization/vector.hpp>
+#include <boost/serialization/map.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/split_member.hpp>
+
+// One token, read from the flat buffers of an InputBuffer.
+struct InputUnit {
+  unsigned wid;
+  unsigned aux_wid;
+  unsigned pid;
+  IdSpan c_id;
+  const std::string& w_str;
+};
+
+struct InputBuffer;
+
+// A sentence, the view of the tokens [first, last) of an InputBuffer. wids
+// points to the word ids of the tokens, which can be replaced by a copy
+// (e.g. the singletons replaced by UNK) without touching the buffer.
+struct InputUnits {
+  const InputBuffer* buffer;
+  unsigned first;
+  unsigned last;
+  const unsigned* wids;
+
+  unsigned size() const { return last - first; }
+  InputUnit operator[](unsigned i) const;
+  InputUnits with_wids(const unsigned* new_wids) const;
+};
+
+// The tokens of a data split in flat buffers. Sentence i covers the tokens
+// [offsets[i], offsets[i + 1]), token j covers the characters
+// [char_offsets[j], char_offsets[j + 1]) and its surface string is interned
+// in surfaces, or in shared_surfaces when the buffer refers to an alphabet
+// that it does not own (which is not saved with the buffer).
+struct InputBuffer {
+  std::vector<unsigned> offsets;
+  std::vector<unsigned> wids;
+  std::vector<unsigned> aux_wids;
+  std::vector<unsigned> pids;
+  std::vector<unsigned> surface_ids;
+  std::vector<unsigned> char_offsets;
+  std::vector<unsigned> c_ids;
+  Alphabet surfaces;
+  const Alphabet* shared_surfaces;
+
+  InputBuffer() : offsets(1, 0), char_offsets(1, 0), shared_surfaces(nullptr) {}
+
+  unsigned size() const { return offsets.size() - 1; }
+  unsigned n_tokens() const { return wids.size(); }
+  const Alphabet& get_surfaces() const { return shared_surfaces ? (*shared_surfaces) : surfaces; }
+
+  InputUnits operator[](unsigned sid) const {
+    InputUnits ret = { this, offsets[sid], offsets[sid + 1], wids.data() + offsets[sid] };
+    return ret;
+  }
+
+  void clear() {
+    offsets.assign(1, 0);
+    wids.clear(); aux_wids.clear(); pids.clear(); surface_ids.clear();
+    char_offsets.assign(1, 0);
+    c_ids.clear();
+    surfaces = Alphabet();
+    shared_surfaces = nullptr;
+  }
+
+  friend class boost::serialization::access;
+  template <class Archive>
+  void serialize(Archive& ar, const unsigned version) {
+    ar & offsets;
+    ar & wids;
+    ar & aux_wids;
+    ar & pids;
+    ar & surface_ids;
+    ar & char_offsets;
+    ar & c_ids;
+    ar & surfaces;
+  }
+};
+
+inline InputUnit InputUnits::operator[](unsigned i) const {
+  unsigned j = first + i;
+  InputUnit ret = {
+    wids[i],
+    buffer->aux_wids[j],
+    buffer->pids[j],
+    IdSpan(buffer->c_ids.data() + buffer->char_offsets[j], buffer->c_ids.data() + buffer->char_offsets[j + 1]),
+    buffer->get_surfaces().get(buffer->surface_ids[j])
+  };
+  return ret;
+}
+
+inline InputUnits InputUnits::with_wids(const unsigned* new_wids) const {
+  InputUnits ret = { buffer, first, last, new_wids };
+  return ret;
+}
+
+// One action, only the ids are kept: the action string is
+// action_map.get(aid) and idx is the index for confirm, newnode, la/ra and
+// entity.
+struct ActionUnit {
+  unsigned aid;
+  unsigned idx;
+};
+
+struct ActionBuffer;
+
+// The actions of a sentence, a view of [first, last) of an ActionBuffer.
+struct ActionUnits {
+  const ActionBuffer* buffer;
+  unsigned first;
+  unsigned last;
+
+  unsigned size() const { return last - first; }
+  ActionUnit operator[](unsigned i) const;
+};
+
+// The actions of a data split in flat buffers, sentence i covers the actions
+// [offsets[i], offsets[i + 1]).
+struct ActionBuffer {
+  std::vector<unsigned> offsets;
+  std::vector<unsigned> aids;
+  std::vector<unsigned> idxs;
+
+  ActionBuffer() : offsets(1, 0) {}
+
+  unsigned size() const { return offsets.size() - 1; }
+
+  ActionUnits operator[](unsigned sid) const {
+    ActionUnits ret = { this, offsets[sid], offsets[sid + 1] };
+    return ret;
+  }
+
+  void clear() {
+    offsets.assign(1, 0);
+    aids.clear();
+    idxs.clear();
+  }
+
+  friend class boost::serialization::access;
+  template <class Archive>
+  void serialize(Archive& ar, const unsigned version) {
+    ar & offsets;
+    ar & aids;
+    ar & idxs;
+  }
+};
+
+inline ActionUnit ActionUnits::operator[](unsigned i) const {
+  ActionUnit ret = { buffer->aids[first + i], buffer->idxs[first + i] };
+  return ret;
+}
+
+struct Corpus {
+  const static unsigned CACHE_VERSION;
+  const static unsigned NO_CONCEPT;  // the idx of a devel/test CONFIRM with an unknown concept.
+  const static char* UNK;
+  const static char* SPAN;
+  const static char* BAD0;
+  const static char* ROOT;
+
+  unsigned n_train;
+  unsigned n_devel;
+  unsigned n_test;
+
+  Alphabet word_map;
+  Alphabet pos_map;
+  Alphabet action_map;
+  Alphabet char_map;
+  Alphabet node_map;
+  Alphabet rel_map;
+  Alphabet entity_map;
+
+  std::unordered_map<unsigned, Alphabet> confirm_map;
+
+  InputBuffer training_inputs;
+  ActionBuffer training_actions;
+  InputBuffer devel_inputs;
+  ActionBuffer devel_actions;
+  InputBuffer test_inputs;
+  ActionBuffer test_actions;
+
+  IdBitmap vocab;      // the words in the training data.
+  IdBitmap singleton;  // the words occurring once in the training data.
+  
+  Corpus();
+
+  /// The action file is mapped into memory and tokenized in place, a .gz or
+  /// .bz2 file is decompressed in chunks by a background thread instead. The
+  /// blocks are parsed by several threads into the thread-local alphabets,
+  /// which are merged in order so the ids are the same as a sequential load.
+  ///
+  /// With use_cache, the parsed training data is kept in filename + ".cache"
+  /// and reused by the later runs until the content of the file changes.
+  void load_training_data(const std::string& filename, bool use_cache = false);
+
+  void load_devel_data(const std::string& filename);
+
+  void load_test_data(const std::string& filename);
+
+  /// The first pass of the streaming training: build the alphabets, the
+  /// vocabulary and the singletons from the training shards chunk by chunk,
+  /// the sentences are not kept. The ids are the same as loading the
+  /// concatenation of the shards with load_training_data.
+  void scan_training_data(const std::vector<std::string>& filenames);
+
+  void get_vocabulary_and_singletons();
+
+  /// Renumber the word, char, node and action alphabets by descending
+  /// frequency in the training data, so the hot embedding rows are close
+  /// to each other. ROOT/UNK and CONFIRM keep their ids. It should be
+  /// called before the pretrained words are loaded.
+  void sort_alphabets();
+
+  /// Freeze the alphabets, they are only looked up afterwards.
+  void freeze();
+
+  unsigned get_or_add_word(const std::string& word);
+
+  /// Collect the words in the word alphabet.
+  void collect_words(std::unordered_set<std::string>& words) const;
+
+  /// Collect the tokens of a data file without touching the alphabets.
+  void collect_words(const std::string& filename,
+                     std::unordered_set<std::string>& words) const;
+
+  void stat();
+
+private:
+  bool load_training_cache(const std::string& filename);
+
+  void save_training_cache(const std::string& filename);
+
+  // the training part of the corpus, the unordered maps are saved in order.
+  friend class boost::serialization::access;
+  template <class Archive>
+  void save(Archive& ar, const unsigned version) const {
+    ar & n_train;
+    ar & word_map;
+    ar & pos_map;
+    ar & action_map;
+    ar & char_map;
+    ar & node_map;
+    ar & rel_map;
+    ar & entity_map;
+    std::map<unsigned, Alphabet> ordered_confirm_map(confirm_map.begin(), confirm_map.end());
+    ar & ordered_confirm_map;
+    ar & training_inputs;
+    ar & training_actions;
+    ar & vocab;
+    ar & singleton;
+  }
+
+  template <class Archive>
+  void load(Archive& ar, const unsigned version) {
+    ar & n_train;
+    ar & word_map;
+    ar & pos_map;
+    ar & action_map;
+    ar & char_map;
+    ar & node_map;
+    ar & rel_map;
+    ar & entity_map;
+    std::map<unsigned, Alphabet> ordered_confirm_map;
+    ar & ordered_confirm_map;
+    confirm_map = std::unordered_map<unsigned, Alphabet>(ordered_confirm_map.begin(), ordered_confirm_map.end());
+    ar & training_inputs;
+    ar & training_actions;
+    ar & vocab;
+    ar & singleton;
+  }
+  BOOST_SERIALIZATION_SPLIT_MEMBER()
+
+  void set_vocabulary_and_singletons(const std::vector<unsigned>& counter);
+
+  /// Load the devel/test data, only looking up the alphabets. The wid of
+  /// a word out of the training vocabulary is UNK, aux_wid keeps its id.
+  /// The idx of an action is resolved as in the training data, or 0 if
+  /// the training data does not have it; a CONFIRM whose concept is not in
+  /// the confirm alphabet of its word gets NO_CONCEPT instead, so it is not
+  /// mistaken for the concept 0.
+  unsigned load_data(const std::string& filename,
+                     InputBuffer& inputs,
+                     ActionBuffer& actions) const;
+};
+
+// Stream the training sentences from the shards scanned by
+// Corpus::scan_training_data, for the training data that does not fit in
+// memory. Each epoch reads the shards in a random order, a chunk of blocks
+// at a time, and draws the sentences at random from a shuffle buffer of
+// buffer_size sentences that is refilled from the shards. Only the buffer
+// and the current chunk are kept in memory.
+//
+// The sentences are looked up in the frozen alphabets. Unlike the loader,
+// a CONFIRM whose word first occurs after it in the data still gets the
+// concept in the confirm alphabet of the word rather than 0.
+struct TrainingStream {
+  TrainingStream(const Corpus& corpus,
+                 const std::vector<std::string>& filenames,
+                 unsigned buffer_size);
+
+  /// Start a new epoch.
+  void reset(std::mt19937& rng);
+
+  /// Draw the next sentence of the epoch, the units are valid until the
+  /// next call. Return false at the end of the epoch.
+  bool next(std::mt19937& rng, InputUnits& input_units, ActionUnits& action_units);
+
+private:
+  // A sentence as flat ids, ROOT included. The surface strings are not kept:
+  // the scan put every training token in word_map, so the surface of a token
+  // is the word of its aux_wid. The vectors are moved between the chunk, the
+  // buffer and the returned sentence, never copied.
+  struct Slot {
+    std::vector<unsigned> wids;
+    std::vector<unsigned> aux_wids;
+    std::vector<unsigned> pids;
+    std::vector<unsigned> char_offsets;
+    std::vector<unsigned> c_ids;
+    std::vector<unsigned> aids;
+    std::vector<unsigned> idxs;
+  };
+
+  bool read(Slot& slot);
+  bool read_chunk();
+  void hand_out(Slot& slot);
+
+  const Corpus& corpus;
+  std::vector<std::string> filenames;
+  std::vector<unsigned> shard_order;
+  unsigned buffer_size;
+  unsigned char_ids[256];
+
+  std::vector<Slot> slots;  // the shuffle buffer, the first n_filled are used.
+  unsigned n_filled;
+  InputBuffer current_inputs;    // the sentence returned by next, the surfaces are word_map.
+  ActionBuffer current_actions;
+
+  unsigned shard;           // the next shard in shard_order.
+  bool in_shard;
+  ChunkReader reader;
+  std::vector<boost::string_ref> blocks;   // the blocks of the current chunk of the shard.
+  unsigned block_next;
+  std::vector<Slot> chunk;  // the parsed sentences of the current chunk.
+  unsigned chunk_next;
+
+  TrainingStream(const TrainingStream&);
+  TrainingStream& operator = (const TrainingStream&);
+};
+
+#endif  //  end for RLPARSER_CORPUS_H
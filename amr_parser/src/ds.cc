@@ -1,62 +1,101 @@
-#include "ds.h"
-#include "logging.h"
-#include <set>
-#include <tuple>
-
-Alphabet::Alphabet() : max_id(0), freezed(false), in_order(true) {
-
-}
-
-void Alphabet::freeze() {
-  freezed = false;
-}
-
-unsigned Alphabet::size() const {
-  return max_id;
-}
-
-unsigned Alphabet::get(const std::string& str) const {
-  const auto found = str_to_id.find(str);
-  if (found == str_to_id.end()) {
-    _ERROR << "Alphabet :: str[\"" << str << "\"] not found!";
-    abort();
-  }
-  return found->second;
-}
-
-std::string Alphabet::get(unsigned id) const {
-  const auto found = id_to_str.find(id);
-  if (found == id_to_str.end()) {
-    _ERROR << "Alphabet :: id[" << id << "] not found!";
-    abort();
-  }
-  return found->second;
-}
-
-bool Alphabet::contains(const std::string& str) const {
-  const auto found = str_to_id.find(str);
-  return (found != str_to_id.end());
-}
-
-bool Alphabet::contains(unsigned id) const {
-  const auto found = id_to_str.find(id);
-  return (found != id_to_str.end());
-}
-
-unsigned Alphabet::insert(const std::string& str) {
-  BOOST_ASSERT_MSG(freezed == false, "Corpus::Insert should not insert into freezed alphabet.");
-  if (contains(str)) {
-    return get(str);
-  }
-
-  str_to_id[str] = max_id;
-  id_to_str[max_id] = str;
-  max_id++;
-  return max_id - 1;
-}
-
-
-unsigned Alphabet::insert(const std::string& str, unsigned id) {
-  _ERROR << "not implemented!";
-  abort();
-}
+#include "ds.h"
+#include "logging.h"
+#include <set>
+#include <tuple>
+
+Alphabet::Alphabet() : max_id(0), freezed(false), in_order(true) {
+
+}
+
+Alphabet::Alphabet(const Alphabet& other) :
+  max_id(other.max_id), id_to_str(other.id_to_str), freezed(other.freezed), in_order(other.in_order) {
+  rebuild_index();
+}
+
+Alphabet::Alphabet(Alphabet&& other) :
+  max_id(other.max_id),
+  str_to_id(std::move(other.str_to_id)),
+  id_to_str(std::move(other.id_to_str)),
+  freezed(other.freezed),
+  in_order(other.in_order) {
+  other.max_id = 0;
+}
+
+Alphabet& Alphabet::operator = (const Alphabet& other) {
+  if (this != &other) {
+    max_id = other.max_id;
+    id_to_str = other.id_to_str;
+    freezed = other.freezed;
+    in_order = other.in_order;
+    rebuild_index();
+  }
+  return (*this);
+}
+
+Alphabet& Alphabet::operator = (Alphabet&& other) {
+  if (this != &other) {
+    max_id = other.max_id;
+    str_to_id = std::move(other.str_to_id);
+    id_to_str = std::move(other.id_to_str);
+    freezed = other.freezed;
+    in_order = other.in_order;
+    other.max_id = 0;
+  }
+  return (*this);
+}
+
+void Alphabet::rebuild_index() {
+  // the keys refer to the strings of this alphabet, not the copied one.
+  str_to_id.clear();
+  str_to_id.reserve(id_to_str.size());
+  for (unsigned i = 0; i < id_to_str.size(); ++i) {
+    str_to_id[boost::string_ref(id_to_str[i])] = i;
+  }
+}
+
+void Alphabet::freeze() {
+  freezed = true;
+}
+
+unsigned Alphabet::size() const {
+  return max_id;
+}
+
+unsigned Alphabet::get(const boost::string_ref& str) const {
+  const auto found = str_to_id.find(str);
+  if (found == str_to_id.end()) {
+    _ERROR << "Alphabet :: str[\"" << str << "\"] not found!";
+    abort();
+  }
+  return found->second;
+}
+
+const std::string& Alphabet::get(unsigned id) const {
+  if (id >= id_to_str.size()) {
+    _ERROR << "Alphabet :: id[" << id << "] not found!";
+    abort();
+  }
+  return id_to_str[id];
+}
+
+bool Alphabet::contains(const boost::string_ref& str) const {
+  return str_to_id.find(str) != str_to_id.end();
+}
+
+bool Alphabet::contains(unsigned id) const {
+  return id < id_to_str.size();
+}
+
+unsigned Alphabet::insert(const boost::string_ref& str) {
+  const auto found = str_to_id.find(str);
+  if (found != str_to_id.end()) {
+    return found->second;
+  }
+  BOOST_ASSERT_MSG(freezed == false, "Corpus::Insert should not insert into freezed alphabet.");
+
+  // deque::push_back keeps the earlier strings in place, so the keys stay valid.
+  id_to_str.push_back(str.to_string());
+  str_to_id[boost::string_ref(id_to_str.back())] = max_id;
+  max_id++;
+  return max_id - 1;
+}
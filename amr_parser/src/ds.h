@@ -1,52 +1,140 @@
-#ifndef RLPARSER_DS_H
-#define RLPARSER_DS_H
-
-#include <string>
-#include <unordered_map>
-#include <boost/functional/hash.hpp>
-
-struct Alphabet {
-  typedef std::unordered_map<std::string, unsigned> StringToIdMap;
-  typedef std::unordered_map<unsigned, std::string> IdToStringMap;
-
-  unsigned max_id;
-  StringToIdMap str_to_id;
-  IdToStringMap id_to_str;
-  bool freezed;
-  bool in_order;
-
-  Alphabet();
-
-  void freeze();
-  unsigned size() const;
-  unsigned get(const std::string& str) const;
-  std::string get(unsigned id) const;
-  bool contains(const std::string& str) const;
-  bool contains(unsigned id) const;
-  unsigned insert(const std::string& str);
-  unsigned insert(const std::string& str, unsigned id);
-};
-
-struct HashVector : public std::vector<unsigned> {
-  bool operator == (const HashVector& other) const {
-    if (size() != other.size()) { return false; }
-    for (unsigned i = 0; i < size(); ++i) {
-      if (at(i) != other.at(i)) { return false; }
-    }
-    return true;
-  }
-};
-
-
-namespace std {
-template<>
-struct hash<HashVector> {
-  std::size_t operator()(const HashVector& values) const {
-    size_t seed = 0;
-    boost::hash_range(seed, values.begin(), values.end());
-    return seed;
-  }
-};
-}
-
+#ifndef RLPARSER_DS_H
+#define RLPARSER_DS_H
+
+#include <string>
+#include <deque>
+#include <unordered_map>
+#include <boost/functional/hash.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <vector>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/vector.hpp>
+#include <boost/serialization/split_member.hpp>
+
+struct StringRefHash {
+  size_t operator()(const boost::string_ref& s) const {
+    return boost::hash_range(s.begin(), s.end());
+  }
+};
+
+// The strings are interned in a deque (the id is the index) and indexed by
+// the string_refs into it, so getting the string of an id is a dense lookup
+// and looking up a string_ref does not allocate. Once frozen, the alphabet
+// only answers the strings that it already has.
+struct Alphabet {
+  typedef std::unordered_map<boost::string_ref, unsigned, StringRefHash> StringToIdMap;
+  typedef std::deque<std::string> IdToStringMap;
+
+  unsigned max_id;
+  StringToIdMap str_to_id;
+  IdToStringMap id_to_str;
+  bool freezed;
+  bool in_order;
+
+  Alphabet();
+  Alphabet(const Alphabet& other);
+  Alphabet(Alphabet&& other);
+  Alphabet& operator = (const Alphabet& other);
+  Alphabet& operator = (Alphabet&& other);
+
+  void freeze();
+  unsigned size() const;
+  unsigned get(const boost::string_ref& str) const;
+  const std::string& get(unsigned id) const;
+  bool contains(const boost::string_ref& str) const;
+  bool contains(unsigned id) const;
+  unsigned insert(const boost::string_ref& str);
+
+  // the strings are saved in the order of their ids.
+  friend class boost::serialization::access;
+  template <class Archive>
+  void save(Archive& ar, const unsigned version) const {
+    std::vector<std::string> strings(id_to_str.begin(), id_to_str.end());
+    ar & strings;
+    ar & freezed;
+    ar & in_order;
+  }
+
+  template <class Archive>
+  void load(Archive& ar, const unsigned version) {
+    std::vector<std::string> strings;
+    ar & strings;
+    str_to_id.clear();
+    id_to_str.clear();
+    max_id = 0;
+    freezed = false;
+    for (const std::string& str : strings) { insert(str); }
+    ar & freezed;
+    ar & in_order;
+  }
+  BOOST_SERIALIZATION_SPLIT_MEMBER()
+
+private:
+  void rebuild_index();
+};
+
+// A read-only view of a contiguous range of ids.
+struct IdSpan {
+  const unsigned* first;
+  const unsigned* last;
+
+  IdSpan() : first(nullptr), last(nullptr) {}
+  IdSpan(const unsigned* first, const unsigned* last) : first(first), last(last) {}
+
+  const unsigned* begin() const { return first; }
+  const unsigned* end() const { return last; }
+  unsigned size() const { return static_cast<unsigned>(last - first); }
+  unsigned operator[](unsigned i) const { return first[i]; }
+};
+
+// A dense set of ids, the membership test is a single bit test.
+struct IdBitmap {
+  std::vector<bool> bits;
+  unsigned n;
+
+  IdBitmap() : n(0) {}
+
+  void insert(unsigned id) {
+    if (id >= bits.size()) { bits.resize(id + 1, false); }
+    if (!bits[id]) { bits[id] = true; ++n; }
+  }
+
+  unsigned count(unsigned id) const {
+    return (id < bits.size() && bits[id]) ? 1 : 0;
+  }
+
+  unsigned size() const { return n; }
+
+  void clear() { bits.clear(); n = 0; }
+
+  friend class boost::serialization::access;
+  template <class Archive>
+  void serialize(Archive& ar, const unsigned version) {
+    ar & bits;
+    ar & n;
+  }
+};
+
+struct HashVector : public std::vector<unsigned> {
+  bool operator == (const HashVector& other) const {
+    if (size() != other.size()) { return false; }
+    for (unsigned i = 0; i < size(); ++i) {
+      if (at(i) != other.at(i)) { return false; }
+    }
+    return true;
+  }
+};
+
+
+namespace std {
+template<>
+struct hash<HashVector> {
+  std::size_t operator()(const HashVector& values) const {
+    size_t seed = 0;
+    boost::hash_range(seed, values.begin(), values.end());
+    return seed;
+  }
+};
+}
+
 #endif  //  end for RLPARSER_DS_H
\ No newline at end of file
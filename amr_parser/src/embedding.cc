@@ -0,0 +1,250 @@
+#include "embedding.h"
+#include "logging.h"
+#include "sys_utils.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <fstream>
+#include <unordered_map>
+#include <sys/stat.h>
+#include <boost/assert.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/algorithm/string.hpp>
+#ifndef _MSC_VER
+#include <unistd.h>
+#endif
+
+const char* PretrainedEmbedding::MAGIC = "TAMREMB";
+const unsigned PretrainedEmbedding::VERSION = 1;
+
+namespace {
+
+struct EmbeddingHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t dim;
+  uint64_t n_rows;
+  uint64_t matrix_offset;
+  uint64_t words_offset;
+  uint64_t words_size;
+};
+
+size_t page_size() {
+#ifndef _MSC_VER
+  long ret = sysconf(_SC_PAGESIZE);
+  return (ret > 0 ? static_cast<size_t>(ret) : 4096);
+#else
+  return 4096;
+#endif
+}
+
+bool read_header(const std::string& filename, EmbeddingHeader& header) {
+  std::ifstream ifs(filename, std::ios::binary);
+  if (!ifs) { return false; }
+  ifs.read(reinterpret_cast<char*>(&header), sizeof(header));
+  return (ifs.gcount() == sizeof(header) &&
+          std::strncmp(header.magic, PretrainedEmbedding::MAGIC, sizeof(header.magic)) == 0);
+}
+
+/// The binary file is reusable if it is newer than the text file and has the same dimension.
+bool binary_is_fresh(const std::string& binary_file,
+                     const std::string& text_file,
+                     unsigned dim) {
+  EmbeddingHeader header;
+  if (!read_header(binary_file, header)) { return false; }
+  if (header.version != PretrainedEmbedding::VERSION || header.dim != dim) { return false; }
+  struct stat binary_stat, text_stat;
+  if (stat(binary_file.c_str(), &binary_stat) != 0 || stat(text_file.c_str(), &text_stat) != 0) {
+    return false;
+  }
+  return binary_stat.st_mtime >= text_stat.st_mtime;
+}
+
+}
+
+PretrainedEmbedding::PretrainedEmbedding() : dim(0) {
+
+}
+
+PretrainedEmbedding::~PretrainedEmbedding() {
+  unmap();
+}
+
+bool PretrainedEmbedding::count(unsigned id) const {
+  return id < rows.size() && rows[id] != nullptr;
+}
+
+const float* PretrainedEmbedding::row(unsigned id) const {
+  BOOST_ASSERT_MSG(count(id), "PretrainedEmbedding:: id not found.");
+  return rows[id];
+}
+
+void PretrainedEmbedding::set(unsigned id, const float* r) {
+  if (id >= rows.size()) { rows.resize(id + 1, nullptr); }
+  rows[id] = r;
+}
+
+unsigned PretrainedEmbedding::size() const {
+  unsigned n = 0;
+  for (const float* r : rows) { if (r != nullptr) { ++n; } }
+  return n;
+}
+
+const char* PretrainedEmbedding::map(const std::string& filename) {
+  const char* base = file.open(filename);
+  BOOST_ASSERT_MSG(file.size() >= sizeof(EmbeddingHeader),
+                   "PretrainedEmbedding:: the binary embedding file is truncated.");
+  return base;
+}
+
+void PretrainedEmbedding::unmap() {
+  file.close();
+}
+
+bool PretrainedEmbedding::is_binary(const std::string& filename) {
+  EmbeddingHeader header;
+  return read_header(filename, header);
+}
+
+void PretrainedEmbedding::convert(const std::string& text_file,
+                                  const std::string& binary_file,
+                                  unsigned dim) {
+  ChunkReader reader;
+  reader.open(text_file, ChunkReader::kLine);
+
+  std::string tmp_file = binary_file + ".tmp." + boost::lexical_cast<std::string>(portable_getpid());
+  std::ofstream ofs(tmp_file, std::ios::binary);
+  BOOST_ASSERT_MSG(ofs, "PretrainedEmbedding:: failed to write the binary embedding file.");
+
+  EmbeddingHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::strncpy(header.magic, MAGIC, sizeof(header.magic));
+  header.version = VERSION;
+  header.dim = dim;
+  header.matrix_offset = page_size();
+  std::vector<char> padding(header.matrix_offset, 0);
+  ofs.write(padding.data(), padding.size());
+
+  std::vector<float> v(dim, 0.f);
+  std::string words;
+  std::string line;
+  unsigned n_skipped = 0;
+  bool first_line = true;
+  const char* data;
+  size_t size;
+  while (reader.next(data, size)) {
+    const char* end = data + size;
+    for (const char* p = data; p < end; ) {
+      const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+      if (eol == nullptr) { eol = end; }
+      line.assign(p, eol);
+      p = eol + 1;
+      // skip the header in word2vec styled embedding.
+      if (first_line) { first_line = false; continue; }
+      const char* b = line.c_str();
+      while (*b == ' ' || *b == '\t') { ++b; }
+      const char* e = b;
+      while (*e != '\0' && *e != ' ' && *e != '\t') { ++e; }
+      if (e == b) { continue; }
+
+      unsigned i = 0;
+      char* num_end = const_cast<char*>(e);
+      for (; i < dim; ++i) {
+        const char* start = num_end;
+        v[i] = std::strtof(start, &num_end);
+        if (num_end == start) { break; }
+      }
+      if (i < dim) { ++n_skipped; continue; }
+
+      ofs.write(reinterpret_cast<const char*>(v.data()), sizeof(float) * dim);
+      words.append(b, e - b);
+      words.push_back('\0');
+      ++header.n_rows;
+    }
+  }
+
+  header.words_offset = header.matrix_offset + header.n_rows * dim * sizeof(float);
+  header.words_size = words.size();
+  ofs.write(words.data(), words.size());
+  ofs.seekp(0);
+  ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  ofs.close();
+  BOOST_ASSERT_MSG(ofs, "PretrainedEmbedding:: failed to write the binary embedding file.");
+  int renamed = std::rename(tmp_file.c_str(), binary_file.c_str());
+  BOOST_ASSERT_MSG(renamed == 0, "PretrainedEmbedding:: failed to rename the binary embedding file.");
+
+  if (n_skipped > 0) {
+    _WARN << "PretrainedEmbedding:: skipped " << n_skipped << " lines with less than " << dim << " dimensions.";
+  }
+  _INFO << "PretrainedEmbedding:: converted " << header.n_rows << " rows into " << binary_file;
+}
+
+void load_pretrained_word_embedding(const std::string& embedding_file,
+                                    unsigned pretrained_dim,
+                                    PretrainedEmbedding& pretrained,
+                                    Corpus& corpus,
+                                    const std::unordered_set<std::string>* needed,
+                                    bool lowercase) {
+  pretrained.dim = pretrained_dim;
+  pretrained.zeros.assign(pretrained_dim, 0.f);
+  pretrained.set(corpus.get_or_add_word(Corpus::BAD0), pretrained.zeros.data());
+  pretrained.set(corpus.get_or_add_word(Corpus::UNK), pretrained.zeros.data());
+  _INFO << "Main:: Loading from " << embedding_file << " with " << pretrained_dim << " dimensions.";
+
+  std::string binary_file = embedding_file;
+  if (!PretrainedEmbedding::is_binary(embedding_file)) {
+    binary_file = embedding_file + ".bin";
+    if (!binary_is_fresh(binary_file, embedding_file, pretrained_dim)) {
+      PretrainedEmbedding::convert(embedding_file, binary_file, pretrained_dim);
+    }
+  }
+
+  const char* base = pretrained.map(binary_file);
+  const EmbeddingHeader* header = reinterpret_cast<const EmbeddingHeader*>(base);
+  BOOST_ASSERT_MSG(header->version == PretrainedEmbedding::VERSION,
+                   "PretrainedEmbedding:: unsupported binary embedding version.");
+  BOOST_ASSERT_MSG(header->dim == pretrained_dim,
+                   "PretrainedEmbedding:: dimension of the binary embedding mismatch --pretrained_dim.");
+
+  const float* matrix = reinterpret_cast<const float*>(base + header->matrix_offset);
+  const char* word = base + header->words_offset;
+
+  // lowercased form -> needed words backing off to it.
+  std::unordered_map<std::string, std::vector<std::string>> backoff;
+  if (needed != nullptr && lowercase) {
+    for (const std::string& w : (*needed)) {
+      std::string lw = boost::algorithm::to_lower_copy(w);
+      if (lw != w) { backoff[lw].push_back(w); }
+    }
+  }
+  std::unordered_map<std::string, const float*> lowercased_rows;
+
+  unsigned n_kept = 0;
+  for (uint64_t i = 0; i < header->n_rows; ++i) {
+    size_t len = std::strlen(word);
+    std::string w(word, len);
+    const float* r = matrix + i * pretrained_dim;
+    word += len + 1;
+    if (needed == nullptr || needed->count(w)) {
+      pretrained.set(corpus.get_or_add_word(w), r);
+      ++n_kept;
+    }
+    if (backoff.count(w)) { lowercased_rows[w] = r; }
+  }
+
+  unsigned n_backoff = 0;
+  for (const auto& payload : lowercased_rows) {
+    for (const std::string& w : backoff[payload.first]) {
+      if (corpus.word_map.contains(w) && pretrained.count(corpus.word_map.get(w))) { continue; }
+      pretrained.set(corpus.get_or_add_word(w), payload.second);
+      ++n_backoff;
+    }
+  }
+
+  _INFO << "Main:: mapped " << header->n_rows << " pretrained rows from " << binary_file;
+  if (needed != nullptr) {
+    _INFO << "Main:: kept " << n_kept << " rows for " << needed->size() << " needed words, "
+      << n_backoff << " words backed off to the lowercased rows.";
+  }
+}
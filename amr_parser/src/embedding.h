@@ -0,0 +1,68 @@
+#ifndef RLPARSER_EMBEDDING_H
+#define RLPARSER_EMBEDDING_H
+
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include "corpus.h"
+#include "sys_utils.h"
+
+// The frozen pretrained word embedding. The rows are stored in a binary,
+// page-aligned matrix file that is memory-mapped read-only, so the parsers
+// read the mapped rows directly and the processes on one host share the
+// same physical pages.
+//
+// Layout of the binary file:
+//  - header (padded to one page): magic, version, dim, n_rows, the offset
+//    of the matrix and the offset/size of the word block.
+//  - matrix: n_rows x dim floats, row-major, starts on a page boundary.
+//  - words: n_rows NUL-terminated words in the order of the rows.
+struct PretrainedEmbedding {
+  const static char* MAGIC;
+  const static unsigned VERSION;
+
+  unsigned dim;
+  std::vector<const float*> rows;  // word id -> mapped row, nullptr if absent.
+  std::vector<float> zeros;        // the row for BAD0 and UNK.
+
+  PretrainedEmbedding();
+  ~PretrainedEmbedding();
+
+  bool count(unsigned id) const;
+  const float* row(unsigned id) const;
+  void set(unsigned id, const float* row);
+  unsigned size() const;
+
+  // map the binary file, return the pointer to the first byte.
+  const char* map(const std::string& filename);
+  void unmap();
+
+  static bool is_binary(const std::string& filename);
+
+  // convert the word2vec styled text embedding (plain, .gz or .bz2) into
+  // the binary file.
+  static void convert(const std::string& text_file,
+                      const std::string& binary_file,
+                      unsigned dim);
+
+private:
+  MappedFile file;
+
+  PretrainedEmbedding(const PretrainedEmbedding&);
+  PretrainedEmbedding& operator = (const PretrainedEmbedding&);
+};
+
+// If the embedding_file is a text file, the binary file is generated
+// as embedding_file + ".bin" once and reused by the later runs.
+//
+// If needed is given, only the rows of the needed words are kept and the
+// other words never touch the word alphabet. With lowercase, a needed word
+// without its own row backs off to the row of its lowercased form.
+void load_pretrained_word_embedding(const std::string& embedding_file,
+                                    unsigned pretrained_dim,
+                                    PretrainedEmbedding& pretrained,
+                                    Corpus& corpus,
+                                    const std::unordered_set<std::string>* needed = nullptr,
+                                    bool lowercase = false);
+
+#endif  //  end for RLPARSER_EMBEDDING_H
@@ -0,0 +1,494 @@
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include "dynet/init.h"
+#include "dynet/expr.h"
+#include "corpus.h"
+#include "embedding.h"
+#include "logging.h"
+#include "math_utils.h"
+#include "sys_utils.h"
+#include "parser/parser_builder.h"
+#include "system/swap.h"
+#include "system/eager.h"
+#include "harness.h"
+#include <boost/lexical_cast.hpp>
+#include <boost/program_options.hpp>
+
+namespace po = boost::program_options;
+
+namespace {
+
+/// The hand-written sentences of the built-in sample, in the format of the
+/// training data. The eager and swap systems have different action sets.
+const char* kEagerSample =
+  "# ::tok The boy wants to go .\n"
+  "# ::pos DT NN VBZ TO VB .\n"
+  "# ::action\tDROP\n"
+  "# ::action\tCONFIRM\tboy\tboy\n"
+  "# ::action\tSHIFT\n"
+  "# ::action\tCONFIRM\twants\twant-01\n"
+  "# ::action\tLEFT\tARG0\n"
+  "# ::action\tSHIFT\n"
+  "# ::action\tDROP\n"
+  "# ::action\tCONFIRM\tgo\tgo-02\n"
+  "# ::action\tCACHE\n"
+  "# ::action\tLEFT\tARG0\n"
+  "# ::action\tRIGHT\tARG1\n"
+  "# ::action\tSHIFT\n"
+  "# ::action\tDROP\n"
+  "# ::action\tREDUCE\n"
+  "# ::action\tREDUCE\n"
+  "# ::action\tREDUCE\n"
+  "# ::action\tSHIFT\n"
+  "# ::action\tREDUCE\n"
+  "\n"
+  "# ::tok Barack Obama visited New York yesterday .\n"
+  "# ::pos NNP NNP VBD NNP NNP NN .\n"
+  "# ::action\tMERGE\n"
+  "# ::action\tENTITY\tperson\n"
+  "# ::action\tNEWNODE\tname\n"
+  "# ::action\tSHIFT\n"
+  "# ::action\tLEFT\tname\n"
+  "# ::action\tSHIFT\n"
+  "# ::action\tCONFIRM\tvisited\tvisit-01\n"
+  "# ::action\tLEFT\tARG0\n"
+  "# ::action\tSHIFT\n"
+  "# ::action\tMERGE\n"
+  "# ::action\tENTITY\tcity\n"
+  "# ::action\tRIGHT\tARG1\n"
+  "# ::action\tSHIFT\n"
+  "# ::action\tCONFIRM\tyesterday\tyesterday\n"
+  "# ::action\tRIGHT\ttime\n"
+  "# ::action\tSHIFT\n"
+  "# ::action\tDROP\n"
+  "# ::action\tREDUCE\n"
+  "# ::action\tREDUCE\n"
+  "# ::action\tREDUCE\n"
+  "# ::action\tREDUCE\n"
+  "# ::action\tREDUCE\n"
+  "# ::action\tSHIFT\n"
+  "# ::action\tREDUCE\n"
+  "\n";
+
+const char* kSwapSample =
+  "# ::tok The boy wants to go .\n"
+  "# ::pos DT NN VBZ TO VB .\n"
+  "# ::action\tSHIFT\n"
+  "# ::action\tREDUCE\n"
+  "# ::action\tSHIFT\n"
+  "# ::action\tCONFIRM\tboy\tboy\n"
+  "# ::action\tSHIFT\n"
+  "# ::action\tCONFIRM\twants\twant-01\n"
+  "# ::action\tLEFT\tARG0\n"
+  "# ::action\tSHIFT\n"
+  "# ::action\tREDUCE\n"
+  "# ::action\tSHIFT\n"
+  "# ::action\tCONFIRM\tgo\tgo-02\n"
+  "# ::action\tRIGHT\tARG1\n"
+  "# ::action\tSWAP\n"
+  "# ::action\tLEFT\tARG0\n"
+  "# ::action\tREDUCE\n"
+  "# ::action\tREDUCE\n"
+  "# ::action\tSHIFT\n"
+  "# ::action\tREDUCE\n"
+  "# ::action\tREDUCE\n"
+  "# ::action\tSHIFT\n"
+  "# ::action\tREDUCE\n"
+  "\n"
+  "# ::tok Barack Obama visited New York yesterday .\n"
+  "# ::pos NNP NNP VBD NNP NNP NN .\n"
+  "# ::action\tSHIFT\n"
+  "# ::action\tSHIFT\n"
+  "# ::action\tMERGE\n"
+  "# ::action\tENTITY\tperson\n"
+  "# ::action\tNEWNODE\tname\n"
+  "# ::action\tRIGHT\tname\n"
+  "# ::action\tREDUCE\n"
+  "# ::action\tSHIFT\n"
+  "# ::action\tCONFIRM\tvisited\tvisit-01\n"
+  "# ::action\tLEFT\tARG0\n"
+  "# ::action\tSHIFT\n"
+  "# ::action\tSHIFT\n"
+  "# ::action\tMERGE\n"
+  "# ::action\tENTITY\tcity\n"
+  "# ::action\tRIGHT\tARG1\n"
+  "# ::action\tREDUCE\n"
+  "# ::action\tSHIFT\n"
+  "# ::action\tCONFIRM\tyesterday\tyesterday\n"
+  "# ::action\tRIGHT\ttime\n"
+  "# ::action\tREDUCE\n"
+  "# ::action\tSHIFT\n"
+  "# ::action\tREDUCE\n"
+  "# ::action\tREDUCE\n"
+  "# ::action\tREDUCE\n"
+  "# ::action\tSHIFT\n"
+  "# ::action\tREDUCE\n"
+  "\n";
+
+/// The words of the synthetic sentences and the pretrained embedding.
+const char* kWords[] = {
+  "the", "boy", "wants", "to", "go", "girl", "believes", "him", "visited",
+  "New", "York", "yesterday", "Barack", "Obama", "city", "."
+};
+const unsigned kNumWords = sizeof(kWords) / sizeof(kWords[0]);
+
+/// The lengths of the synthetic sentences, for the benchmarks by length.
+const unsigned kLengths[] = { 5, 10, 20, 40, 80 };
+const unsigned kNumLengths = sizeof(kLengths) / sizeof(kLengths[0]);
+
+/// The hand-written sentences followed by a synthetic sentence of each of
+/// kLengths tokens, whose words are confirmed or dropped in turn.
+std::string make_sample(bool swap) {
+  std::ostringstream os;
+  os << (swap ? kSwapSample : kEagerSample);
+  for (unsigned len : kLengths) {
+    std::vector<std::string> words;
+    for (unsigned i = 0; i < len; ++i) { words.push_back(kWords[i % kNumWords]); }
+    os << "# ::tok";
+    for (const std::string& w : words) { os << " " << w; }
+    os << "\n";
+    for (unsigned i = 0; i < len; ++i) {
+      if (swap) {
+        os << "# ::action\tSHIFT\n";
+        if (i % 2 == 0) { os << "# ::action\tCONFIRM\t" << words[i] << "\t" << words[i] << "\n"; }
+        os << "# ::action\tREDUCE\n";
+      } else if (i % 2 == 0) {
+        os << "# ::action\tCONFIRM\t" << words[i] << "\t" << words[i] << "\n";
+        os << "# ::action\tSHIFT\n";
+        os << "# ::action\tREDUCE\n";
+      } else {
+        os << "# ::action\tDROP\n";
+      }
+    }
+    os << "# ::action\tSHIFT\n";
+    os << "# ::action\tREDUCE\n";
+    os << "\n";
+  }
+  return os.str();
+}
+
+void write_file(const std::string& filename, const std::string& content, unsigned repeat) {
+  std::ofstream ofs(filename);
+  for (unsigned i = 0; i < repeat; ++i) { ofs << content; }
+}
+
+/// A word2vec styled text embedding of kWords.
+void write_embedding(const std::string& filename, unsigned dim) {
+  std::ofstream ofs(filename);
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> dis(-1.f, 1.f);
+  ofs << kNumWords << " " << dim << "\n";
+  for (unsigned i = 0; i < kNumWords; ++i) {
+    ofs << kWords[i];
+    for (unsigned d = 0; d < dim; ++d) { ofs << " " << dis(rng); }
+    ofs << "\n";
+  }
+}
+
+/// The sentence of the training data with n_tokens tokens besides ROOT.
+unsigned find_sentence(const InputBuffer& inputs, unsigned n_tokens) {
+  for (unsigned sid = 0; sid < inputs.size(); ++sid) {
+    if (inputs[sid].size() == n_tokens + 1) { return sid; }
+  }
+  BOOST_ASSERT_MSG(false, "bench:: no sentence of the length in the sample.");
+  return 0;
+}
+
+/// The actions of a walk from the initial state of input, each drawn from
+/// the valid actions with rng, at most 500 as in decoding. Replaying the
+/// walk visits the same states, so every action is valid.
+std::vector<unsigned> record_walk(TransitionSystem& sys, const InputUnits& input, std::mt19937& rng) {
+  std::vector<unsigned> actions;
+  std::vector<unsigned> valid_actions;
+  State state(input.size());
+  Parser::initialize_state(input, state);
+  while (!state.terminated() && actions.size() < 500) {
+    sys.get_valid_actions(state, valid_actions);
+    std::uniform_int_distribution<unsigned> dis(0, valid_actions.size() - 1);
+    unsigned action = valid_actions[dis(rng)];
+    sys.perform_action(state, action);
+    actions.push_back(action);
+  }
+  return actions;
+}
+
+volatile unsigned long sink;
+
+}
+
+void init_command_line(int argc, char* argv[], po::variables_map& conf) {
+  po::options_description general("Microbenchmarks of the AMR parser on a built-in sample.");
+  general.add_options()
+    ("architecture", po::value<std::string>()->default_value("eager"), "The architecture of the parser benchmarks [swap, eager].")
+    ("system", po::value<std::string>()->default_value("eager"), "The transition system of the parser benchmarks [swap, eager].")
+    ("filter", po::value<std::string>()->default_value(""), "Only run the benchmarks whose name contains this.")
+    ("min_time_ms", po::value<double>()->default_value(200.), "The minimum time of each benchmark.")
+    ("sample_repeat", po::value<unsigned>()->default_value(50), "The number of copies of the sample in the loading benchmark.")
+    ("work_dir", po::value<std::string>()->default_value("/tmp"), "The directory of the temporary sample files.")
+    ("json", po::value<std::string>(), "Write the results as JSON to this file, - for stdout.")
+    ("layers", po::value<unsigned>()->default_value(2), "The number of layers in LSTM.")
+    ("word_dim", po::value<unsigned>()->default_value(100), "Word dim")
+    ("pos_dim", po::value<unsigned>()->default_value(20), "POS dim, set it as 0 to disable POS.")
+    ("pretrained_dim", po::value<unsigned>()->default_value(100), "Pretrained input dimension.")
+    ("char_dim", po::value<unsigned>()->default_value(50), "Character input dimension.")
+    ("action_dim", po::value<unsigned>()->default_value(20), "The dimension for action.")
+    ("relation_dim", po::value<unsigned>()->default_value(32), "The dimension for relation.")
+    ("entity_dim", po::value<unsigned>()->default_value(32), "The dimension for entity.")
+    ("lstm_input_dim", po::value<unsigned>()->default_value(100), "The dimension for lstm input.")
+    ("hidden_dim", po::value<unsigned>()->default_value(100), "The dimension for hidden unit.")
+    ("random_seed", po::value<unsigned>()->default_value(7743), "The value of random seed.")
+    ("verbose,v", "Details logging.")
+    ("help,h", "show help information")
+    ;
+
+  po::store(po::parse_command_line(argc, argv, general), conf);
+  if (conf.count("help")) {
+    std::cerr << general << std::endl;
+    exit(1);
+  }
+  init_boost_log(conf.count("verbose") > 0);
+  // the loaders log every load.
+  if (!conf.count("verbose")) { log_min_severity = boost::log::trivial::warning; }
+}
+
+int main(int argc, char** argv) {
+  dynet::initialize(argc, argv, false);
+  po::variables_map conf;
+  init_command_line(argc, argv, conf);
+  dynet::rndeng = new std::mt19937(conf["random_seed"].as<unsigned>());
+
+  BenchRunner runner(conf["min_time_ms"].as<double>(), conf["filter"].as<std::string>());
+  std::string prefix = conf["work_dir"].as<std::string>() + "/bench_amr_parser." +
+    boost::lexical_cast<std::string>(portable_getpid());
+  std::string eager_file = prefix + ".eager.txt";
+  std::string swap_file = prefix + ".swap.txt";
+  std::string embedding_file = prefix + ".emb.txt";
+  write_file(eager_file, make_sample(false), conf["sample_repeat"].as<unsigned>());
+  write_file(swap_file, make_sample(true), 1);
+  unsigned pretrained_dim = conf["pretrained_dim"].as<unsigned>();
+  write_embedding(embedding_file, pretrained_dim);
+
+  // loaders.
+  runner.run("corpus/load_training_data", [&](BenchTimer& timer) -> unsigned long {
+    Corpus corpus;
+    corpus.load_training_data(eager_file);
+    return corpus.n_train;
+  });
+
+  Corpus eager_corpus;
+  eager_corpus.load_training_data(eager_file);
+  eager_corpus.get_vocabulary_and_singletons();
+  Corpus swap_corpus;
+  swap_corpus.load_training_data(swap_file);
+  swap_corpus.get_vocabulary_and_singletons();
+
+  runner.run("embedding/convert", [&](BenchTimer& timer) -> unsigned long {
+    PretrainedEmbedding::convert(embedding_file, embedding_file + ".convert.bin", pretrained_dim);
+    return 1;
+  });
+  std::remove((embedding_file + ".convert.bin").c_str());
+
+  // the needed words are all in the alphabet, so the corpus is not changed.
+  std::unordered_set<std::string> needed;
+  eager_corpus.collect_words(needed);
+  runner.run("embedding/load_pretrained", [&](BenchTimer& timer) -> unsigned long {
+    PretrainedEmbedding pretrained;
+    load_pretrained_word_embedding(embedding_file, pretrained_dim, pretrained, eager_corpus, &needed);
+    return 1;
+  });
+  PretrainedEmbedding pretrained;
+  load_pretrained_word_embedding(embedding_file, pretrained_dim, pretrained, eager_corpus, &needed);
+  eager_corpus.freeze();
+  swap_corpus.freeze();
+
+  // alphabets.
+  std::vector<std::string> words(eager_corpus.word_map.id_to_str.begin(),
+                                 eager_corpus.word_map.id_to_str.end());
+  runner.run("alphabet/get_id", [&](BenchTimer& timer) -> unsigned long {
+    unsigned long sum = 0;
+    for (const std::string& w : words) { sum += eager_corpus.word_map.get(w); }
+    sink = sum;
+    return words.size();
+  });
+  runner.run("alphabet/get_string", [&](BenchTimer& timer) -> unsigned long {
+    unsigned long sum = 0;
+    for (unsigned id = 0; id < words.size(); ++id) { sum += eager_corpus.word_map.get(id).size(); }
+    sink = sum;
+    return words.size();
+  });
+  runner.run("alphabet/contains_miss", [&](BenchTimer& timer) -> unsigned long {
+    unsigned long sum = 0;
+    for (const std::string& w : words) { sum += eager_corpus.pos_map.contains(w); }
+    sink = sum;
+    return words.size();
+  });
+
+  // transition systems, replaying the walks on the whole sample.
+  Eager eager(eager_corpus.action_map, eager_corpus.node_map, eager_corpus.rel_map, eager_corpus.entity_map);
+  Swap swap(swap_corpus.action_map, swap_corpus.node_map, swap_corpus.rel_map, swap_corpus.entity_map);
+  struct Replay {
+    const char* name;
+    TransitionSystem* sys;
+    const Corpus* corpus;
+    std::vector<std::vector<unsigned>> walks;
+  };
+  Replay replays[] = {
+    { "eager", &eager, &eager_corpus, std::vector<std::vector<unsigned>>() },
+    { "swap", &swap, &swap_corpus, std::vector<std::vector<unsigned>>() }
+  };
+  std::mt19937 walk_rng(conf["random_seed"].as<unsigned>());
+  for (Replay& replay : replays) {
+    const InputBuffer& inputs = replay.corpus->training_inputs;
+    // the sample repeats, one copy has all the distinct sentences.
+    unsigned n = std::min(inputs.size(), 2 + kNumLengths);
+    for (unsigned sid = 0; sid < n; ++sid) {
+      replay.walks.push_back(record_walk(*replay.sys, inputs[sid], walk_rng));
+    }
+  }
+  for (Replay& replay : replays) {
+    runner.run(std::string(replay.name) + "/valid_and_perform", [&](BenchTimer& timer) -> unsigned long {
+      unsigned long n_actions = 0;
+      std::vector<unsigned> valid_actions;
+      for (unsigned sid = 0; sid < replay.walks.size(); ++sid) {
+        State state(replay.corpus->training_inputs[sid].size());
+        Parser::initialize_state(replay.corpus->training_inputs[sid], state);
+        for (unsigned action : replay.walks[sid]) {
+          replay.sys->get_valid_actions(state, valid_actions);
+          replay.sys->perform_action(state, action);
+        }
+        n_actions += replay.walks[sid].size();
+      }
+      return n_actions;
+    });
+    runner.run(std::string(replay.name) + "/perform_action", [&](BenchTimer& timer) -> unsigned long {
+      unsigned long n_actions = 0;
+      for (unsigned sid = 0; sid < replay.walks.size(); ++sid) {
+        State state(replay.corpus->training_inputs[sid].size());
+        Parser::initialize_state(replay.corpus->training_inputs[sid], state);
+        for (unsigned action : replay.walks[sid]) { replay.sys->perform_action(state, action); }
+        n_actions += replay.walks[sid].size();
+      }
+      return n_actions;
+    });
+  }
+
+  // math utils, on a score vector of the size of the eager actions.
+  {
+    std::mt19937 rng(conf["random_seed"].as<unsigned>());
+    std::uniform_real_distribution<float> dis(-5.f, 5.f);
+    std::vector<float> scores(std::max(64u, eager.num_actions()));
+    for (float& s : scores) { s = dis(rng); }
+    std::vector<unsigned> valid_indices;
+    for (unsigned i = 0; i < scores.size(); i += 2) { valid_indices.push_back(i); }
+    std::vector<float> prob(scores);
+    softmax_inplace(prob);
+    std::vector<unsigned> population(10000);
+    for (unsigned i = 0; i < population.size(); ++i) { population[i] = i; }
+    std::vector<unsigned> reservoir(100);
+    std::vector<float> x(scores.size());
+
+    runner.run("math/softmax_inplace", [&](BenchTimer& timer) -> unsigned long {
+      for (unsigned i = 0; i < 1000; ++i) { x = scores; softmax_inplace(x); }
+      return 1000;
+    });
+    runner.run("math/softmax_inplace_on_valid", [&](BenchTimer& timer) -> unsigned long {
+      for (unsigned i = 0; i < 1000; ++i) { x = scores; softmax_inplace_on_valid_indicies(x, valid_indices); }
+      return 1000;
+    });
+    runner.run("math/distribution_sample", [&](BenchTimer& timer) -> unsigned long {
+      unsigned long sum = 0;
+      for (unsigned i = 0; i < 1000; ++i) { sum += distribution_sample(prob, rng); }
+      sink = sum;
+      return 1000;
+    });
+    runner.run("math/fast_reservoir_sample_100_of_10000", [&](BenchTimer& timer) -> unsigned long {
+      for (unsigned i = 0; i < 100; ++i) {
+        fast_reservoir_sample_n(population, population.size(), reservoir, reservoir.size(), rng);
+      }
+      return 100;
+    });
+    runner.run("math/fisher_yates_shuffle_100_of_10000", [&](BenchTimer& timer) -> unsigned long {
+      unsigned long sum = 0;
+      for (unsigned i = 0; i < 100; ++i) { sum += fisher_yates_shuffle(100, 10000, rng)[0]; }
+      sink = sum;
+      return 100;
+    });
+  }
+
+  // the parser, on the synthetic sentences of the sample.
+  const bool swap_system = (conf["system"].as<std::string>() == "swap");
+  Replay& replay = replays[swap_system ? 1 : 0];
+  std::string parser_name = "parser_" + conf["architecture"].as<std::string>();
+  std::vector<std::string> init_names;
+  for (unsigned len : kLengths) {
+    init_names.push_back(parser_name + "/initialize_parser/len=" + boost::lexical_cast<std::string>(len));
+  }
+  bool run_parser = runner.selected(parser_name + "/step");
+  for (const std::string& name : init_names) { run_parser = run_parser || runner.selected(name); }
+  if (run_parser) {
+    dynet::ParameterCollection model;
+    Parser* parser = ParserBuilder().build(conf, model, *replay.sys, *replay.corpus, pretrained);
+    BOOST_ASSERT_MSG(parser != nullptr, "bench:: unknown architecture.");
+    parser->inactivate_training();
+
+    for (unsigned i = 0; i < kNumLengths; ++i) {
+      InputUnits input = replay.corpus->training_inputs[find_sentence(replay.corpus->training_inputs, kLengths[i])];
+      runner.run(init_names[i], [&](BenchTimer& timer) -> unsigned long {
+        dynet::ComputationGraph cg;
+        State state(input.size());
+        parser->new_graph(cg);
+        parser->initialize(cg, input, state);
+        if (!cg.nodes.empty()) { cg.incremental_forward(cg.nodes.size() - 1); }
+        return 1;
+      });
+    }
+
+    // a step as in decoding: the valid actions, the forward of the scores
+    // (and of the concepts for CONFIRM) and performing the action. The
+    // actions follow a walk, the encoder is excluded.
+    unsigned sid = find_sentence(replay.corpus->training_inputs, 20);
+    InputUnits input = replay.corpus->training_inputs[sid];
+    std::vector<unsigned> walk = record_walk(*replay.sys, input, walk_rng);
+    runner.run(parser_name + "/step", [&](BenchTimer& timer) -> unsigned long {
+      timer.stop();
+      dynet::ComputationGraph cg;
+      State state(input.size());
+      parser->new_graph(cg);
+      parser->initialize(cg, input, state);
+      if (!cg.nodes.empty()) { cg.incremental_forward(cg.nodes.size() - 1); }
+      timer.start();
+      std::vector<unsigned> valid_actions;
+      for (unsigned action : walk) {
+        replay.sys->get_valid_actions(state, valid_actions);
+        std::vector<float> scores = dynet::as_vector(cg.get_value(parser->get_scores()));
+        if (action == 0) {
+          unsigned wid = (swap_system ? state.stack.back().first : state.buffer.back().first);
+          std::vector<float> confirm_scores = dynet::as_vector(cg.get_value(parser->get_confirm_values(wid)));
+          sink = confirm_scores.size();
+        }
+        sink = scores.size();
+        parser->perform_action(action, cg, state);
+      }
+      return walk.size();
+    });
+  }
+
+  std::remove(eager_file.c_str());
+  std::remove(swap_file.c_str());
+  std::remove(embedding_file.c_str());
+  std::remove((embedding_file + ".bin").c_str());
+
+  runner.write_table(std::cout);
+  if (conf.count("json")) {
+    std::string json = conf["json"].as<std::string>();
+    if (json == "-") {
+      runner.write_json(std::cout);
+    } else {
+      std::ofstream ofs(json);
+      runner.write_json(ofs);
+    }
+  }
+  return 0;
+}
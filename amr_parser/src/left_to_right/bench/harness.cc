@@ -0,0 +1,136 @@
+#include "harness.h"
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+
+namespace {
+
+std::atomic<unsigned long> n_allocations(0);
+std::atomic<unsigned long> n_allocated_bytes(0);
+
+/// Escape the quote and the backslash of a json string.
+std::string json_escape(const std::string& s) {
+  std::string ret;
+  for (char c : s) {
+    if (c == '"' || c == '\\') { ret += '\\'; }
+    ret += c;
+  }
+  return ret;
+}
+
+}
+
+// the array forms and the nothrow forms call these in libstdc++ and libc++.
+void* operator new(std::size_t size) {
+  ++n_allocations;
+  n_allocated_bytes += size;
+  void* p = std::malloc(size == 0 ? 1 : size);
+  if (p == nullptr) { throw std::bad_alloc(); }
+  return p;
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+  std::free(p);
+}
+
+unsigned long get_allocation_count() {
+  return n_allocations;
+}
+
+unsigned long get_allocated_bytes() {
+  return n_allocated_bytes;
+}
+
+BenchTimer::BenchTimer() :
+  elapsed_ns(0.), n_allocs(0), n_bytes(0), running(false), allocs_start(0), bytes_start(0) {
+}
+
+void BenchTimer::start() {
+  if (running) { return; }
+  running = true;
+  allocs_start = get_allocation_count();
+  bytes_start = get_allocated_bytes();
+  t_start = Clock::now();
+}
+
+void BenchTimer::stop() {
+  if (!running) { return; }
+  elapsed_ns += std::chrono::duration<double, std::nano>(Clock::now() - t_start).count();
+  n_allocs += get_allocation_count() - allocs_start;
+  n_bytes += get_allocated_bytes() - bytes_start;
+  running = false;
+}
+
+BenchRunner::BenchRunner(double min_time_ms, const std::string& filter) :
+  min_time_ms(min_time_ms), filter(filter) {
+}
+
+bool BenchRunner::selected(const std::string& name) const {
+  return filter.empty() || name.find(filter) != std::string::npos;
+}
+
+void BenchRunner::run(const std::string& name, const Batch& batch) {
+  if (!selected(name)) { return; }
+  BenchTimer warmup;
+  warmup.start();
+  batch(warmup);
+
+  BenchTimer timer;
+  unsigned long n_ops = 0;
+  do {
+    BenchTimer last = timer;
+    timer.start();
+    unsigned long n = batch(timer);
+    timer.stop();
+    // an empty batch makes no progress, and its time belongs to no operation.
+    if (n == 0) { timer = last; break; }
+    n_ops += n;
+  } while (timer.elapsed_ns < min_time_ms * 1e6);
+
+  if (n_ops == 0) {
+    std::cerr << "bench:: " << name << " skipped, the batch did no operation." << std::endl;
+    return;
+  }
+
+  BenchResult result;
+  result.name = name;
+  result.n_ops = n_ops;
+  result.ns_per_op = timer.elapsed_ns / n_ops;
+  result.allocs_per_op = static_cast<double>(timer.n_allocs) / n_ops;
+  result.bytes_per_op = static_cast<double>(timer.n_bytes) / n_ops;
+  results.push_back(result);
+  std::cerr << "bench:: " << name << " " << std::fixed << std::setprecision(1)
+    << result.ns_per_op << " ns/op" << std::endl;
+}
+
+void BenchRunner::write_table(std::ostream& os) const {
+  os << std::left << std::setw(40) << "benchmark" << std::right
+    << std::setw(12) << "ops" << std::setw(14) << "ns/op"
+    << std::setw(14) << "allocs/op" << std::setw(14) << "bytes/op" << std::endl;
+  for (const BenchResult& r : results) {
+    os << std::left << std::setw(40) << r.name << std::right
+      << std::setw(12) << r.n_ops
+      << std::fixed << std::setprecision(1) << std::setw(14) << r.ns_per_op
+      << std::setprecision(2) << std::setw(14) << r.allocs_per_op
+      << std::setprecision(1) << std::setw(14) << r.bytes_per_op << std::endl;
+  }
+}
+
+void BenchRunner::write_json(std::ostream& os) const {
+  os << "{\"benchmarks\":[";
+  for (unsigned i = 0; i < results.size(); ++i) {
+    const BenchResult& r = results[i];
+    os << (i == 0 ? "\n" : ",\n") << "  {\"name\":\"" << json_escape(r.name) << "\""
+      << ",\"ops\":" << r.n_ops
+      << std::fixed << std::setprecision(3)
+      << ",\"ns_per_op\":" << r.ns_per_op
+      << ",\"allocs_per_op\":" << r.allocs_per_op
+      << ",\"bytes_per_op\":" << r.bytes_per_op << "}";
+  }
+  os << "\n]}" << std::endl;
+}
@@ -0,0 +1,67 @@
+#ifndef BENCH_HARNESS_H
+#define BENCH_HARNESS_H
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// The heap allocations of this process, counted by the replaced global
+// operator new of bench_amr_parser. The memory pools of DyNet are not on
+// the heap and not counted.
+unsigned long get_allocation_count();
+unsigned long get_allocated_bytes();
+
+// Time a batch. The timer is running when the batch is called, its setup can
+// be excluded with stop/start. The allocations are counted over the same
+// periods.
+struct BenchTimer {
+  typedef std::chrono::high_resolution_clock Clock;
+
+  BenchTimer();
+  void start();
+  void stop();
+
+  double elapsed_ns;
+  unsigned long n_allocs;
+  unsigned long n_bytes;
+
+private:
+  bool running;
+  Clock::time_point t_start;
+  unsigned long allocs_start;
+  unsigned long bytes_start;
+};
+
+struct BenchResult {
+  std::string name;
+  unsigned long n_ops;
+  double ns_per_op;
+  double allocs_per_op;
+  double bytes_per_op;
+};
+
+// Run the benchmarks whose name contains filter. A batch does some
+// operations and returns their number; it is run once to warm up, then
+// repeated until min_time_ms of timed work has passed. A batch that does no
+// operation stops the repetition; a benchmark without any is not reported.
+struct BenchRunner {
+  typedef std::function<unsigned long(BenchTimer&)> Batch;
+
+  BenchRunner(double min_time_ms, const std::string& filter);
+
+  bool selected(const std::string& name) const;
+  void run(const std::string& name, const Batch& batch);
+
+  void write_table(std::ostream& os) const;
+  void write_json(std::ostream& os) const;
+
+  std::vector<BenchResult> results;
+
+private:
+  double min_time_ms;
+  std::string filter;
+};
+
+#endif  //  end for BENCH_HARNESS_H
@@ -2,13 +2,16 @@
 #include <fstream>
 #include <set>
 #include <chrono>
+#include <algorithm>
 #include "dynet/init.h"
 #include "corpus.h"
+#include "embedding.h"
 #include "logging.h"
 #include "parser/parser_builder.h"
 #include "system/swap.h"
 #include "system/eager.h"
 #include "evaluate/evaluate.h"
+#include "evaluate/latency.h"
 #include "sys_utils.h"
 #include "trainer_utils.h"
 #include <boost/program_options.hpp>
@@ -24,6 +27,8 @@ void init_command_line(int argc, char* argv[], po::variables_map& conf) {
     ("algorithm", po::value<std::string>()->default_value("supervised"),
      "The choice of reinforcement learning algorithm [supervised]")
     ("training_data,T", po::value<std::string>(), "The path to the training data.")
+    ("corpus_cache", "Cache the parsed training data in a binary file next to it.")
+    ("sort_alphabets", "Renumber the alphabets by training frequency, the model should be loaded with the same flag.")
     ("devel_data,d", po::value<std::string>(), "The path to the development data.")
     ("test_data,e", po::value<std::string>(), "The path to the test data.")
     ("pretrained,w", po::value<std::string>(), "The path to the word embedding.")
@@ -35,6 +40,9 @@ void init_command_line(int argc, char* argv[], po::variables_map& conf) {
     ("word_dim", po::value<unsigned>()->default_value(100), "Word dim")
     ("pos_dim", po::value<unsigned>()->default_value(20), "POS dim, set it as 0 to disable POS.")
     ("pretrained_dim", po::value<unsigned>()->default_value(100), "Pretrained input dimension.")
+    ("pretrained_prune", "Only keep the pretrained rows of the words in the training/devel/test data of "
+      "this run; the model does not depend on them, so it decodes other data.")
+    ("pretrained_lowercase", "Back off to the lowercased pretrained row for the pruned words.")
     ("char_dim", po::value<unsigned>()->default_value(50), "Character input dimension.")
     ("newnode_dim", po::value<unsigned>()->default_value(100), "Newnode embedding dimension.")
     ("action_dim", po::value<unsigned>()->default_value(20), "The dimension for action.")
@@ -66,7 +74,6 @@ float ensemble(const po::variables_map & conf,
                const std::string & output,
                bool devel) {
   auto t_start = std::chrono::high_resolution_clock::now();
-  unsigned kUNK = corpus.get_or_add_word(Corpus::UNK);
 
   std::ofstream ofs(output);
   for (auto parser : parsers) {
@@ -74,14 +81,15 @@ float ensemble(const po::variables_map & conf,
   }
 
   unsigned n = (devel ? corpus.n_devel : corpus.n_test);
-  std::unordered_map<unsigned, InputUnits> & inputs = (devel ?
-                                                       corpus.devel_inputs :
-                                                       corpus.test_inputs);
+  const InputBuffer & inputs = (devel ?
+                                corpus.devel_inputs :
+                                corpus.test_inputs);
 
   unsigned n_engines = parsers.size();
+  LatencyStats latency;
 
   for (unsigned sid = 0; sid < n; ++sid) {
-    InputUnits & input_units = inputs[sid];
+    InputUnits input_units = inputs[sid];
 
     ofs << "# ::tok";
     for (unsigned i = 0; i < input_units.size() - 1; ++i) {
@@ -89,11 +97,8 @@ float ensemble(const po::variables_map & conf,
     }
     ofs << std::endl;
 
-    for (InputUnit & u : input_units) {
-      if (!corpus.vocab.count(u.wid)) { u.wid = kUNK; }
-    }
+    LatencyStats::Clock::time_point t_sentence = LatencyStats::Clock::now();
     dynet::ComputationGraph cg;
-    ActionUnits output;
 
     unsigned len = input_units.size();
     std::vector<State> states(n_engines, State(len));
@@ -102,6 +107,10 @@ float ensemble(const po::variables_map & conf,
       parsers[i]->new_graph(cg);
       parsers[i]->initialize(cg, input_units, states[i]);
     }
+    // run the encoders here, otherwise they are run lazily by the first action.
+    if (!cg.nodes.empty()) { cg.incremental_forward(cg.nodes.size() - 1); }
+    double encode_ms = LatencyStats::elapsed_ms(t_sentence);
+    LatencyStats::Clock::time_point t_decode = LatencyStats::Clock::now();
 
     unsigned n_actions = 0;
     while (!states[0].terminated() && n_actions++ < 500) {
@@ -175,6 +184,7 @@ float ensemble(const po::variables_map & conf,
         parsers[j]->perform_action(best_a, cg, states[j]);
       }
     }
+    latency.add(len - 1, encode_ms, LatencyStats::elapsed_ms(t_decode), std::min(n_actions, 500u));
 
     ofs << std::endl;
   }
@@ -186,8 +196,9 @@ float ensemble(const po::variables_map & conf,
                                           conf["devel_gold"].as<std::string>() : conf["test_gold"].as<std::string>()) +
                                          " " +
                                          output);
-  _INFO << "Evaluate:: Smatch " << f_score << " [" << corpus.n_devel <<
+  _INFO << "Evaluate:: Smatch " << f_score << " [" << n <<
         " sents in " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms]";
+  latency.report(devel ? "devel" : "test");
   return f_score;
 }
 
@@ -201,18 +212,28 @@ int main(int argc, char** argv) {
   init_command_line(argc, argv, conf);
 
   Corpus corpus;
-  corpus.load_training_data(conf["training_data"].as<std::string>());
+  corpus.load_training_data(conf["training_data"].as<std::string>(), conf.count("corpus_cache") > 0);
+  if (conf.count("sort_alphabets")) { corpus.sort_alphabets(); }
   corpus.stat();
 
   corpus.get_vocabulary_and_singletons();
 
-  std::unordered_map<unsigned, std::vector<float>> pretrained;
+  PretrainedEmbedding pretrained;
   if (conf.count("pretrained")) {
+    std::unordered_set<std::string> needed;
+    if (conf.count("pretrained_prune")) {
+      corpus.collect_words(needed);
+      if (conf.count("devel_data")) { corpus.collect_words(conf["devel_data"].as<std::string>(), needed); }
+      if (conf.count("test_data")) { corpus.collect_words(conf["test_data"].as<std::string>(), needed); }
+    }
     load_pretrained_word_embedding(conf["pretrained"].as<std::string>(),
                                    conf["pretrained_dim"].as<unsigned>(),
-                                   pretrained, corpus);
+                                   pretrained, corpus,
+                                   conf.count("pretrained_prune") ? &needed : nullptr,
+                                   conf.count("pretrained_lowercase") > 0);
   }
   _INFO << "Main:: after loading pretrained embedding, size(vocabulary)=" << corpus.word_map.size();
+  corpus.freeze();
 
 
   TransitionSystem* sys = nullptr;
@@ -240,7 +261,7 @@ int main(int argc, char** argv) {
     models[i] = new dynet::ParameterCollection;
     parsers[i] = ParserBuilder().build(conf, (*models[i]), (*sys), corpus, pretrained);
 
-    dynet::load_dynet_model(model_paths[i], models[i]);
+    ParserBuilder::load(model_paths[i], (*models[i]));
   }
 
   corpus.load_devel_data(conf["devel_data"].as<std::string>());
@@ -1,224 +1,324 @@
-#include "evaluate.h"
-#include "logging.h"
-#include "sys_utils.h"
-#include <fstream>
-#include <chrono>
-
-float evaluate(const po::variables_map & conf,
-               Corpus & corpus,
-               Parser & parser,
-               const std::string & output,
-               bool devel) {
-  auto t_start = std::chrono::high_resolution_clock::now();
-  unsigned kUNK = corpus.get_or_add_word(Corpus::UNK);
-
-  std::ofstream ofs(output);
-  parser.inactivate_training();
-
-  unsigned n = (devel ? corpus.n_devel : corpus.n_test);
-  std::unordered_map<unsigned, InputUnits> & inputs = (devel ? corpus.devel_inputs : corpus.test_inputs);
-
-  for (unsigned sid = 0; sid < n; ++sid) {
-
-    ofs << "# ::tok";
-    for (unsigned i = 0; i < inputs[sid].size() - 1; ++i) { //except for _ROOT_
-      ofs << " " << inputs[sid][i].w_str;
-    }
-    ofs << std::endl;
-
-    InputUnits& input_units = inputs[sid];
-
-    for (InputUnit& u : input_units) {
-      if (!corpus.vocab.count(u.wid)) { u.wid = kUNK; }
-    }
-    dynet::ComputationGraph cg;
-    ActionUnits output;
-
-    unsigned len = input_units.size();
-    State state(len);
-
-    parser.new_graph(cg);
-
-    parser.initialize(cg, input_units, state);
-    unsigned n_actions = 0;
-    while (!state.terminated() && n_actions++ < 500) {
-      // collect all valid actions.
-      std::vector<unsigned> valid_actions;
-      parser.sys.get_valid_actions(state, valid_actions);
-      //std::cerr << valid_actions.size() << std::endl;
-
-      std::vector<float> scores = dynet::as_vector(cg.get_value(parser.get_scores()));
-
-      auto payload = Parser::get_best_action(scores, valid_actions);
-      unsigned best_a = payload.first;
-      unsigned best_c = 0;
-      //if CONFIRM
-      if (best_a == 0) {
-        unsigned wid = 0;
-        if (conf["system"].as<std::string>() == "swap") {
-          wid = state.stack.back().first;
-        } else if (conf["system"].as<std::string>() == "eager") {
-          wid = state.buffer.back().first;
-        } else {
-          BOOST_ASSERT_MSG(false, "Illegal System");
-        }
-
-        std::vector<float> confirm_scores = dynet::as_vector(cg.get_value(parser.get_confirm_values(wid)));
-        float best_score = -1e9f;
-        for (unsigned i = 0; i < confirm_scores.size(); i++) {
-          if (confirm_scores[i] > best_score) {
-            best_score = confirm_scores[i];
-            best_c = i;
-          }
-        }
-        //std::cerr << "# ::action\t" << "CONFIRM\t" <<
-        //  corpus.word_map.get(wid) << "\t";
-        ofs << "# ::action\t"
-            << "CONFIRM\t"
-            << (corpus.word_map.contains(wid) ? corpus.word_map.get(wid) : std::string("_UNK_"))
-            << "\t";
-        if (corpus.confirm_map.find(wid) == corpus.confirm_map.end()) {
-          //std::cerr << corpus.word_map.get(wid) << std::endl;
-          ofs << (corpus.word_map.contains(wid) ? corpus.word_map.get(wid) : std::string("_UNK_")) << std::endl;
-        } else {
-          //std::cerr << corpus.confirm_map[wid].get(best_c) << std::endl;
-          ofs << corpus.confirm_map[wid].get(best_c) << std::endl;
-        }
-        
-          
-      } else {
-        //std::cerr << "# ::action\t" << parser.sys.action_map.get(best_a) << std::endl;
-        ofs << "# ::action\t" << parser.sys.action_map.get(best_a) << std::endl;
-      }
-      parser.perform_action(best_a, cg, state);
-    }
-
-    for (InputUnit& u : input_units) { u.wid = u.aux_wid; }
-
-    ofs << std::endl;
-
-    //ofs && confirm
-  }
-  ofs.close();
-  auto t_end = std::chrono::high_resolution_clock::now();
-  float f_score = execute_and_get_result(conf["external_eval"].as<std::string>() +
-                                           " " +
-                                           (devel ?
-                                            conf["devel_gold"].as<std::string>() : conf["test_gold"].as<std::string>()) +
-                                           " " +
-                                           output);
-  _INFO << "Evaluate:: Smatch " << f_score << " [" << corpus.n_devel <<
-    " sents in " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms]";
-  return f_score;
-}
-
-float evaluate_oracle(const po::variables_map & conf,
-                      Corpus & corpus,
-                      Parser & parser,
-                      const std::string & output,
-                      bool devel) {
-  auto t_start = std::chrono::high_resolution_clock::now();
-  unsigned kUNK = corpus.get_or_add_word(Corpus::UNK);
-
-  std::ofstream ofs(output);
-  parser.inactivate_training();
-
-  unsigned n = (devel ? corpus.n_devel : corpus.n_test);
-  std::unordered_map<unsigned, InputUnits> & inputs = (devel ? corpus.devel_inputs : corpus.test_inputs);
-  std::unordered_map<unsigned, ActionUnits> & actions = (devel ? corpus.devel_actions : corpus.test_actions);
-
-  for (unsigned sid = 0; sid < n; ++sid) {
-
-    ofs << "# ::tok";
-    for (unsigned i = 0; i < inputs[sid].size() - 1; ++i) { //except for _ROOT_
-      ofs << " " << inputs[sid][i].w_str;
-    }
-    ofs << std::endl;
-
-    InputUnits& input_units = inputs[sid];
-    ActionUnits & parse_units = actions[sid];
-
-    for (InputUnit& u : input_units) {
-      if (!corpus.vocab.count(u.wid)) { u.wid = kUNK; }
-    }
-    dynet::ComputationGraph cg;
-    ActionUnits output;
-
-    unsigned len = input_units.size();
-    State state(len);
-
-    parser.new_graph(cg);
-
-    parser.initialize(cg, input_units, state);
-    unsigned n_actions = 0;
-    while (!state.terminated() && n_actions++ < 500) {
-      // collect all valid actions.
-      std::vector<unsigned> valid_actions;
-      parser.sys.get_valid_actions(state, valid_actions);
-      //std::cerr << valid_actions.size() << std::endl;
-
-      std::vector<float> scores = dynet::as_vector(cg.get_value(parser.get_scores()));
-
-      auto payload = Parser::get_best_action(scores, valid_actions);
-      unsigned best_a = payload.first;
-      unsigned best_c = 0;
-      //if CONFIRM
-      if (best_a == 0) {
-        unsigned wid = 0;
-        if (conf["system"].as<std::string>() == "swap") {
-          wid = state.stack.back().first;
-        } else if (conf["system"].as<std::string>() == "eager") {
-          wid = state.buffer.back().first;
-        } else {
-          BOOST_ASSERT_MSG(false, "Illegal System");
-        }
-
-        std::vector<float> confirm_scores = dynet::as_vector(cg.get_value(parser.get_confirm_values(wid)));
-        float best_score = -1e9f;
-        for (unsigned i = 0; i < confirm_scores.size(); i++) {
-          if (confirm_scores[i] > best_score) {
-            best_score = confirm_scores[i];
-            best_c = i;
-          }
-        }
-        //std::cerr << "# ::action\t" << "CONFIRM\t" <<
-        //  corpus.word_map.get(wid) << "\t";
-        ofs << "# ::action\t"
-            << "CONFIRM\t"
-            << (corpus.word_map.contains(wid) ? corpus.word_map.get(wid) : std::string("_UNK_"))
-            << "\t";
-        if (corpus.confirm_map.find(wid) == corpus.confirm_map.end()) {
-          //std::cerr << corpus.word_map.get(wid) << std::endl;
-          ofs << (corpus.word_map.contains(wid) ? corpus.word_map.get(wid) : std::string("_UNK_")) << std::endl;
-        } else {
-          //std::cerr << corpus.confirm_map[wid].get(best_c) << std::endl;
-          ofs << corpus.confirm_map[wid].get(best_c) << std::endl;
-        }
-
-
-      } else {
-        //std::cerr << "# ::action\t" << parser.sys.action_map.get(best_a) << std::endl;
-        ofs << "# ::action\t" << parser.sys.action_map.get(best_a) << std::endl;
-      }
-      best_a = parse_units[n_actions].aid;
-      parser.perform_action(best_a, cg, state);
-    }
-
-    for (InputUnit& u : input_units) { u.wid = u.aux_wid; }
-
-    ofs << std::endl;
-
-    //ofs && confirm
-  }
-  ofs.close();
-  auto t_end = std::chrono::high_resolution_clock::now();
-  float f_score = execute_and_get_result(conf["external_eval"].as<std::string>() +
-                                         " " +
-                                         (devel ?
-                                          conf["devel_gold"].as<std::string>() : conf["test_gold"].as<std::string>()) +
-                                         " " +
-                                         output);
-  _INFO << "Evaluate:: Smatch " << f_score << " [" << corpus.n_devel <<
-        " sents in " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms]";
-  return f_score;
-}
+#include "evaluate.h"
+#include "latency.h"
+#include "logging.h"
+#include "profile_utils.h"
+#include "sys_utils.h"
+#include "trace_utils.h"
+#include <fstream>
+#include <chrono>
+#include <map>
+#include <algorithm>
+
+float evaluate(const po::variables_map & conf,
+               Corpus & corpus,
+               Parser & parser,
+               const std::string & output,
+               bool devel) {
+  auto t_start = std::chrono::high_resolution_clock::now();
+
+  std::ofstream ofs(output);
+  parser.inactivate_training();
+
+  unsigned n = (devel ? corpus.n_devel : corpus.n_test);
+  const InputBuffer & inputs = (devel ? corpus.devel_inputs : corpus.test_inputs);
+  LatencyStats latency;
+  TraceSpan evaluate_span(devel ? "evaluate_devel" : "evaluate_test", "evaluate");
+  evaluate_span.add_arg("sentences", n);
+
+  for (unsigned sid = 0; sid < n; ++sid) {
+
+    ofs << "# ::tok";
+    for (unsigned i = 0; i < inputs[sid].size() - 1; ++i) { //except for _ROOT_
+      ofs << " " << inputs[sid][i].w_str;
+    }
+    ofs << std::endl;
+
+    InputUnits input_units = inputs[sid];
+
+    LatencyStats::Clock::time_point t_sentence = LatencyStats::Clock::now();
+    dynet::ComputationGraph cg;
+
+    unsigned len = input_units.size();
+    State state(len);
+    TraceSpan encode_span("encode", "parse");
+    encode_span.add_arg("sid", sid);
+    encode_span.add_arg("tokens", len - 1);
+
+    parser.new_graph(cg);
+
+    parser.initialize(cg, input_units, state);
+    // run the encoder here, otherwise it is run lazily by the first action.
+    if (!cg.nodes.empty()) { cg.incremental_forward(cg.nodes.size() - 1); }
+    double encode_ms = LatencyStats::elapsed_ms(t_sentence);
+    encode_span.end();
+    LatencyStats::Clock::time_point t_decode = LatencyStats::Clock::now();
+    TraceSpan decode_span("decode", "parse");
+    decode_span.add_arg("sid", sid);
+    unsigned n_actions = 0;
+    while (!state.terminated() && n_actions++ < 500) {
+      // collect all valid actions.
+      std::vector<unsigned> valid_actions;
+      parser.sys.get_valid_actions(state, valid_actions);
+      //std::cerr << valid_actions.size() << std::endl;
+
+      std::vector<float> scores;
+      {
+        PROFILE_SCOPE("get_scores forward");
+        scores = dynet::as_vector(cg.get_value(parser.get_scores()));
+      }
+
+      auto payload = Parser::get_best_action(scores, valid_actions);
+      unsigned best_a = payload.first;
+      unsigned best_c = 0;
+      //if CONFIRM
+      if (best_a == 0) {
+        unsigned wid = 0;
+        if (conf["system"].as<std::string>() == "swap") {
+          wid = state.stack.back().first;
+        } else if (conf["system"].as<std::string>() == "eager") {
+          wid = state.buffer.back().first;
+        } else {
+          BOOST_ASSERT_MSG(false, "Illegal System");
+        }
+
+        std::vector<float> confirm_scores;
+        {
+          PROFILE_SCOPE("get_confirm_values forward");
+          confirm_scores = dynet::as_vector(cg.get_value(parser.get_confirm_values(wid)));
+        }
+        float best_score = -1e9f;
+        for (unsigned i = 0; i < confirm_scores.size(); i++) {
+          if (confirm_scores[i] > best_score) {
+            best_score = confirm_scores[i];
+            best_c = i;
+          }
+        }
+        //std::cerr << "# ::action\t" << "CONFIRM\t" <<
+        //  corpus.word_map.get(wid) << "\t";
+        ofs << "# ::action\t"
+            << "CONFIRM\t"
+            << (corpus.word_map.contains(wid) ? corpus.word_map.get(wid) : std::string("_UNK_"))
+            << "\t";
+        if (corpus.confirm_map.find(wid) == corpus.confirm_map.end()) {
+          //std::cerr << corpus.word_map.get(wid) << std::endl;
+          ofs << (corpus.word_map.contains(wid) ? corpus.word_map.get(wid) : std::string("_UNK_")) << std::endl;
+        } else {
+          //std::cerr << corpus.confirm_map[wid].get(best_c) << std::endl;
+          ofs << corpus.confirm_map[wid].get(best_c) << std::endl;
+        }
+        
+          
+      } else {
+        //std::cerr << "# ::action\t" << parser.sys.action_map.get(best_a) << std::endl;
+        ofs << "# ::action\t" << parser.sys.action_map.get(best_a) << std::endl;
+      }
+      parser.perform_action(best_a, cg, state);
+    }
+    latency.add(len - 1, encode_ms, LatencyStats::elapsed_ms(t_decode), std::min(n_actions, 500u));
+    decode_span.add_arg("actions", std::min(n_actions, 500u));
+    decode_span.end();
+
+
+    ofs << std::endl;
+
+    //ofs && confirm
+  }
+  ofs.close();
+  auto t_end = std::chrono::high_resolution_clock::now();
+  float f_score = execute_and_get_result(conf["external_eval"].as<std::string>() +
+                                           " " +
+                                           (devel ?
+                                            conf["devel_gold"].as<std::string>() : conf["test_gold"].as<std::string>()) +
+                                           " " +
+                                           output);
+  _INFO << "Evaluate:: Smatch " << f_score << " [" << n <<
+    " sents in " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms]";
+  latency.report(devel ? "devel" : "test");
+  return f_score;
+}
+
+float evaluate_oracle(const po::variables_map & conf,
+                      Corpus & corpus,
+                      Parser & parser,
+                      const std::string & output,
+                      bool devel) {
+  auto t_start = std::chrono::high_resolution_clock::now();
+
+  std::ofstream ofs(output);
+  parser.inactivate_training();
+
+  unsigned n = (devel ? corpus.n_devel : corpus.n_test);
+  const InputBuffer & inputs = (devel ? corpus.devel_inputs : corpus.test_inputs);
+  TraceSpan evaluate_span(devel ? "evaluate_oracle_devel" : "evaluate_oracle_test", "evaluate");
+  evaluate_span.add_arg("sentences", n);
+  const ActionBuffer & actions = (devel ? corpus.devel_actions : corpus.test_actions);
+
+  for (unsigned sid = 0; sid < n; ++sid) {
+
+    ofs << "# ::tok";
+    for (unsigned i = 0; i < inputs[sid].size() - 1; ++i) { //except for _ROOT_
+      ofs << " " << inputs[sid][i].w_str;
+    }
+    ofs << std::endl;
+
+    InputUnits input_units = inputs[sid];
+    ActionUnits parse_units = actions[sid];
+
+    dynet::ComputationGraph cg;
+
+    unsigned len = input_units.size();
+    State state(len);
+
+    parser.new_graph(cg);
+
+    parser.initialize(cg, input_units, state);
+    unsigned n_actions = 0;
+    while (!state.terminated() && n_actions++ < 500) {
+      // collect all valid actions.
+      std::vector<unsigned> valid_actions;
+      parser.sys.get_valid_actions(state, valid_actions);
+      //std::cerr << valid_actions.size() << std::endl;
+
+      std::vector<float> scores = dynet::as_vector(cg.get_value(parser.get_scores()));
+
+      auto payload = Parser::get_best_action(scores, valid_actions);
+      unsigned best_a = payload.first;
+      unsigned best_c = 0;
+      //if CONFIRM
+      if (best_a == 0) {
+        unsigned wid = 0;
+        if (conf["system"].as<std::string>() == "swap") {
+          wid = state.stack.back().first;
+        } else if (conf["system"].as<std::string>() == "eager") {
+          wid = state.buffer.back().first;
+        } else {
+          BOOST_ASSERT_MSG(false, "Illegal System");
+        }
+
+        std::vector<float> confirm_scores = dynet::as_vector(cg.get_value(parser.get_confirm_values(wid)));
+        float best_score = -1e9f;
+        for (unsigned i = 0; i < confirm_scores.size(); i++) {
+          if (confirm_scores[i] > best_score) {
+            best_score = confirm_scores[i];
+            best_c = i;
+          }
+        }
+        //std::cerr << "# ::action\t" << "CONFIRM\t" <<
+        //  corpus.word_map.get(wid) << "\t";
+        ofs << "# ::action\t"
+            << "CONFIRM\t"
+            << (corpus.word_map.contains(wid) ? corpus.word_map.get(wid) : std::string("_UNK_"))
+            << "\t";
+        if (corpus.confirm_map.find(wid) == corpus.confirm_map.end()) {
+          //std::cerr << corpus.word_map.get(wid) << std::endl;
+          ofs << (corpus.word_map.contains(wid) ? corpus.word_map.get(wid) : std::string("_UNK_")) << std::endl;
+        } else {
+          //std::cerr << corpus.confirm_map[wid].get(best_c) << std::endl;
+          ofs << corpus.confirm_map[wid].get(best_c) << std::endl;
+        }
+
+
+      } else {
+        //std::cerr << "# ::action\t" << parser.sys.action_map.get(best_a) << std::endl;
+        ofs << "# ::action\t" << parser.sys.action_map.get(best_a) << std::endl;
+      }
+      best_a = parse_units[n_actions].aid;
+      parser.perform_action(best_a, cg, state);
+    }
+
+
+    ofs << std::endl;
+
+    //ofs && confirm
+  }
+  ofs.close();
+  auto t_end = std::chrono::high_resolution_clock::now();
+  float f_score = execute_and_get_result(conf["external_eval"].as<std::string>() +
+                                         " " +
+                                         (devel ?
+                                          conf["devel_gold"].as<std::string>() : conf["test_gold"].as<std::string>()) +
+                                         " " +
+                                         output);
+  _INFO << "Evaluate:: Smatch " << f_score << " [" << n <<
+        " sents in " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms]";
+  return f_score;
+}
+
+void get_proxy_devel(const Corpus & corpus,
+                     unsigned n,
+                     std::vector<unsigned> & sids) {
+  std::vector<unsigned> order(corpus.n_devel);
+  for (unsigned sid = 0; sid < corpus.n_devel; ++sid) { order[sid] = sid; }
+  std::stable_sort(order.begin(), order.end(), [&corpus](unsigned a, unsigned b) {
+    return corpus.devel_inputs[a].size() < corpus.devel_inputs[b].size();
+  });
+
+  sids.clear();
+  n = std::min(n, corpus.n_devel);
+  for (unsigned k = 0; k < n; ++k) {
+    sids.push_back(order[(2 * k + 1) * static_cast<size_t>(corpus.n_devel) / (2 * n)]);
+  }
+  std::sort(sids.begin(), sids.end());
+}
+
+float evaluate_proxy(const po::variables_map & conf,
+                     Corpus & corpus,
+                     Parser & parser,
+                     const std::vector<unsigned> & sids) {
+  auto t_start = std::chrono::high_resolution_clock::now();
+  parser.inactivate_training();
+  TraceSpan evaluate_span("evaluate_proxy", "evaluate");
+  evaluate_span.add_arg("sentences", sids.size());
+  const bool swap = (conf["system"].as<std::string>() == "swap");
+
+  // the idx only tells the CONFIRMs apart, the other actions have it in aid.
+  // A gold CONFIRM of an unknown concept has the idx NO_CONCEPT, which no
+  // prediction has, so it counts as a miss.
+  typedef std::pair<unsigned, unsigned> Key;
+  unsigned n_matched = 0, n_predicted = 0, n_gold = 0;
+  for (unsigned sid : sids) {
+    InputUnits input_units = corpus.devel_inputs[sid];
+    ActionUnits gold_units = corpus.devel_actions[sid];
+
+    std::map<Key, unsigned> gold;
+    for (unsigned i = 0; i < gold_units.size(); ++i) {
+      ActionUnit a = gold_units[i];
+      ++gold[Key(a.aid, a.aid == 0 ? a.idx : 0)];
+    }
+    n_gold += gold_units.size();
+
+    dynet::ComputationGraph cg;
+    State state(input_units.size());
+    parser.new_graph(cg);
+    parser.initialize(cg, input_units, state);
+    unsigned n_actions = 0;
+    while (!state.terminated() && n_actions++ < 500) {
+      std::vector<unsigned> valid_actions;
+      parser.sys.get_valid_actions(state, valid_actions);
+      std::vector<float> scores = dynet::as_vector(cg.get_value(parser.get_scores()));
+      unsigned best_a = Parser::get_best_action(scores, valid_actions).first;
+      unsigned best_c = 0;
+      if (best_a == 0) {
+        unsigned wid = (swap ? state.stack.back().first : state.buffer.back().first);
+        std::vector<float> confirm_scores = dynet::as_vector(cg.get_value(parser.get_confirm_values(wid)));
+        best_c = std::max_element(confirm_scores.begin(), confirm_scores.end()) - confirm_scores.begin();
+      }
+
+      auto found = gold.find(Key(best_a, best_c));
+      if (found != gold.end() && found->second > 0) {
+        --found->second;
+        ++n_matched;
+      }
+      ++n_predicted;
+      parser.perform_action(best_a, cg, state);
+    }
+  }
+
+  float p = (n_predicted > 0 ? float(n_matched) / n_predicted : 0.f);
+  float r = (n_gold > 0 ? float(n_matched) / n_gold : 0.f);
+  float f_score = (p + r > 0.f ? 2.f * p * r / (p + r) : 0.f);
+  auto t_end = std::chrono::high_resolution_clock::now();
+  _INFO << "Evaluate:: proxy action F " << f_score << " [" << sids.size() <<
+    " sents in " << std::chrono::duration<double, std::milli>(t_end - t_start).count() << " ms]";
+  return f_score;
+}
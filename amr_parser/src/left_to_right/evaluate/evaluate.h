@@ -1,25 +1,40 @@
-#ifndef EVALUATE_H
-#define EVALUATE_H
-
-#include <iostream>
-#include <set>
-#include "corpus.h"
-#include "parser/parser.h"
-#include <boost/program_options.hpp>
-
-namespace po = boost::program_options;
-
-float evaluate(const po::variables_map & conf,
-               Corpus & corpus,
-               Parser & parser,
-               const std::string& output,
-               bool devel);
-
-float evaluate_oracle(const po::variables_map & conf,
-                      Corpus & corpus,
-                      Parser & parser,
-                      const std::string& output,
-                      bool devel);
-
-
+#ifndef EVALUATE_H
+#define EVALUATE_H
+
+#include <iostream>
+#include <set>
+#include "corpus.h"
+#include "parser/parser.h"
+#include <boost/program_options.hpp>
+
+namespace po = boost::program_options;
+
+float evaluate(const po::variables_map & conf,
+               Corpus & corpus,
+               Parser & parser,
+               const std::string& output,
+               bool devel);
+
+float evaluate_oracle(const po::variables_map & conf,
+                      Corpus & corpus,
+                      Parser & parser,
+                      const std::string& output,
+                      bool devel);
+
+// Pick n development sentences stratified by length: the sentences are
+// sorted by length and taken at even intervals, so the subset is fixed.
+void get_proxy_devel(const Corpus & corpus,
+                     unsigned n,
+                     std::vector<unsigned> & sids);
+
+// The cheap proxy of Smatch for the intermediate evaluations: decode the
+// given development sentences and return the F-score of the predicted
+// actions against the gold actions, matched as bags (a CONFIRM also by
+// its concept). The external evaluation is not run.
+float evaluate_proxy(const po::variables_map & conf,
+                     Corpus & corpus,
+                     Parser & parser,
+                     const std::vector<unsigned> & sids);
+
+
 #endif  //  end for EVALUATE_H
\ No newline at end of file
@@ -0,0 +1,86 @@
+#include "latency.h"
+#include "logging.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+/// The upper bounds (inclusive) of the length buckets, the last is open.
+const unsigned kBucketBounds[] = { 10, 20, 40, 80 };
+const unsigned kNumBuckets = sizeof(kBucketBounds) / sizeof(kBucketBounds[0]) + 1;
+
+unsigned get_bucket(unsigned n_tokens) {
+  unsigned b = 0;
+  while (b + 1 < kNumBuckets && n_tokens > kBucketBounds[b]) { ++b; }
+  return b;
+}
+
+std::string bucket_name(unsigned b) {
+  std::ostringstream os;
+  unsigned lower = (b == 0 ? 1 : kBucketBounds[b - 1] + 1);
+  if (b + 1 < kNumBuckets) {
+    os << lower << "-" << kBucketBounds[b];
+  } else {
+    os << lower << "+";
+  }
+  return os.str();
+}
+
+/// Write p50/p90/p99/max of the values by the nearest rank, values are sorted.
+void write_percentiles(std::ostream& os, const char* name, std::vector<float>& values) {
+  std::sort(values.begin(), values.end());
+  auto at = [&values](double q) {
+    size_t rank = static_cast<size_t>(std::ceil(q * values.size()));
+    return values[std::min(values.size(), std::max<size_t>(rank, 1)) - 1];
+  };
+  os << " " << name << " p50=" << at(0.5) << " p90=" << at(0.9)
+     << " p99=" << at(0.99) << " max=" << values.back();
+}
+
+}
+
+void LatencyStats::add(unsigned n_tokens, double encode_ms, double decode_ms, unsigned n_actions) {
+  Sample sample = { n_tokens, static_cast<float>(encode_ms), static_cast<float>(decode_ms), n_actions };
+  samples.push_back(sample);
+}
+
+void LatencyStats::clear() {
+  samples.clear();
+}
+
+unsigned LatencyStats::size() const {
+  return samples.size();
+}
+
+double LatencyStats::elapsed_ms(const Clock::time_point& start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void LatencyStats::report(const std::string& name) const {
+  if (samples.empty()) { return; }
+  // bucket kNumBuckets is all the sentences.
+  for (unsigned b = 0; b <= kNumBuckets; ++b) {
+    std::vector<float> total, encode, decode, actions;
+    for (const Sample& s : samples) {
+      if (b < kNumBuckets && get_bucket(s.n_tokens) != b) { continue; }
+      total.push_back(s.encode_ms + s.decode_ms);
+      encode.push_back(s.encode_ms);
+      decode.push_back(s.decode_ms);
+      actions.push_back(s.n_actions);
+    }
+    if (total.empty()) { continue; }
+
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(2);
+    os << "Latency:: " << name << " [" << (b < kNumBuckets ? bucket_name(b) + " tokens" : std::string("all"))
+       << ", " << total.size() << " sents]";
+    write_percentiles(os, "total_ms", total);
+    write_percentiles(os, "encode_ms", encode);
+    write_percentiles(os, "decode_ms", decode);
+    os << std::setprecision(1);
+    write_percentiles(os, "actions", actions);
+    _INFO << os.str();
+  }
+}
@@ -0,0 +1,35 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+// The per-sentence latency of decoding. A sentence is timed in two parts:
+// encode (building the graph and running the encoder in initialize) and
+// decode (the loop of scoring and performing the actions). The report has
+// the p50/p90/p99/max of the total, encode and decode time and the actions
+// per sentence, for all the sentences and by sentence-length bucket.
+struct LatencyStats {
+  typedef std::chrono::high_resolution_clock Clock;
+
+  void add(unsigned n_tokens, double encode_ms, double decode_ms, unsigned n_actions);
+  void clear();
+  unsigned size() const;
+
+  // log the report, one line per bucket.
+  void report(const std::string& name) const;
+
+  static double elapsed_ms(const Clock::time_point& start);
+
+private:
+  struct Sample {
+    unsigned n_tokens;
+    float encode_ms;
+    float decode_ms;
+    unsigned n_actions;
+  };
+  std::vector<Sample> samples;
+};
+
+#endif  //  end for LATENCY_H
@@ -1,19 +1,22 @@
-#ifndef PARSER_BUILDER_H
-#define PARSER_BUILDER_H
-
-#include <iostream>
-#include "parser.h"
-#include "dynet/model.h"
-#include <boost/program_options.hpp>
-
-namespace po = boost::program_options;
-
-struct ParserBuilder {
-  static po::options_description get_options();
-  static Parser* build(const po::variables_map& conf,
-                       dynet::ParameterCollection& model,
-                       TransitionSystem& sys,
-                       const Corpus& corpus,
-                       const std::unordered_map<unsigned, std::vector<float>>& pretrained);
-};
+#ifndef PARSER_BUILDER_H
+#define PARSER_BUILDER_H
+
+#include <iostream>
+#include "parser.h"
+#include "embedding.h"
+#include "dynet/model.h"
+#include <boost/program_options.hpp>
+
+namespace po = boost::program_options;
+
+struct ParserBuilder {
+  static po::options_description get_options();
+  static Parser* build(const po::variables_map& conf,
+                       dynet::ParameterCollection& model,
+                       TransitionSystem& sys,
+                       const Corpus& corpus,
+                       const PretrainedEmbedding& pretrained);
+  // load the parameters into the model made by build, exit if they do not fit.
+  static void load(const std::string& path, dynet::ParameterCollection& model);
+};
 #endif  //  end for PARSER_BUILDER_H
\ No newline at end of file
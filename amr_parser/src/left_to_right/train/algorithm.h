@@ -1,6 +1,6 @@
-#ifndef TRAIN_ALGORITHM_H
-#define TRAIN_ALGORITHM_H
-
-#include "train/train_supervised.h"
-
+#ifndef TRAIN_ALGORITHM_H
+#define TRAIN_ALGORITHM_H
+
+#include "train/train_supervised.h"
+
 #endif  //  end for TRAIN_ALGORITHM
\ No newline at end of file
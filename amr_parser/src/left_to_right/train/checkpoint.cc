@@ -0,0 +1,87 @@
+#include "checkpoint.h"
+#include "logging.h"
+#include "sys_utils.h"
+#include "trace_utils.h"
+#include "trainer_utils.h"
+#include <cstdio>
+#include <fstream>
+#include <boost/assert.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+
+const unsigned Checkpoint::VERSION = 3;
+
+Checkpoint::Checkpoint() :
+  iter(0), position(0), logc(0), llh(0.f), best_f(0.f), best_proxy(-1.f),
+  n_stale_evals(0), learning_rate(0.f), updates(0.f) {
+}
+
+void Checkpoint::snapshot(dynet::ParameterCollection& model, dynet::Trainer& trainer) {
+  values.resize(count_parameter_values(model));
+  flatten_parameters(model, values.data());
+  save_trainer_state(trainer, trainer_state);
+  learning_rate = trainer.learning_rate;
+  updates = trainer.updates;
+}
+
+void Checkpoint::restore(dynet::ParameterCollection& model, dynet::Trainer& trainer) const {
+  BOOST_ASSERT_MSG(values.size() == count_parameter_values(model),
+                   "Checkpoint:: the checkpoint does not match the model.");
+  unflatten_parameters(values.data(), model);
+  load_trainer_state(trainer_state, trainer);
+  trainer.learning_rate = learning_rate;
+  trainer.updates = updates;
+}
+
+bool Checkpoint::load(const std::string& filename) {
+  std::ifstream ifs(filename, std::ios::binary);
+  if (!ifs) { return false; }
+  try {
+    boost::archive::binary_iarchive ia(ifs);
+    unsigned version = 0;
+    ia >> version;
+    if (version != VERSION) {
+      _WARN << "Checkpoint:: " << filename << " has version " << version << ", expected " << VERSION;
+      return false;
+    }
+    ia >> (*this);
+  } catch (const std::exception& e) {
+    // a truncated checkpoint, e.g. the disk filled up while writing it.
+    _WARN << "Checkpoint:: failed to read " << filename << ": " << e.what();
+    return false;
+  }
+  return true;
+}
+
+CheckpointWriter::CheckpointWriter() {
+}
+
+CheckpointWriter::~CheckpointWriter() {
+  wait();
+}
+
+void CheckpointWriter::write(const std::string& filename, Checkpoint& checkpoint) {
+  wait();
+  std::swap(pending, checkpoint);
+  worker = std::thread([this, filename]() {
+    TraceSpan span("write_checkpoint", "checkpoint");
+    std::string tmp_file = filename + ".tmp." + boost::lexical_cast<std::string>(portable_getpid());
+    {
+      std::ofstream ofs(tmp_file, std::ios::binary);
+      boost::archive::binary_oarchive oa(ofs);
+      oa << Checkpoint::VERSION << pending;
+    }
+    if (std::rename(tmp_file.c_str(), filename.c_str()) != 0) {
+      _WARN << "Checkpoint:: failed to rename " << tmp_file << " to " << filename;
+      std::remove(tmp_file.c_str());
+      return;
+    }
+    _INFO << "Checkpoint:: saved iter #" << pending.iter << " at sentence " << pending.position
+      << " to " << filename;
+  });
+}
+
+void CheckpointWriter::wait() {
+  if (worker.joinable()) { worker.join(); }
+}
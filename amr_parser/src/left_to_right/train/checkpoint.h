@@ -0,0 +1,88 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include "dynet/model.h"
+#include "dynet/training.h"
+#include "trainer_utils.h"
+#include <boost/serialization/vector.hpp>
+#include <boost/serialization/string.hpp>
+
+// A full training checkpoint: the parameters, the optimizer state and the
+// state of the training loop, so an interrupted training resumes from where
+// it was rather than from scratch.
+struct Checkpoint {
+  const static unsigned VERSION;
+
+  unsigned iter;
+  unsigned position;            // the number of sentences of iter already trained.
+  unsigned logc;
+  std::vector<unsigned> order;  // the shuffled order of iter.
+  float llh;
+  float best_f;
+  float best_proxy;
+  unsigned n_stale_evals;
+  std::string rng_state;        // the state of dynet::rndeng.
+  std::string order_rng_state;  // the state of the shuffling generator of the workers.
+
+  float learning_rate;
+  float updates;
+  TrainerState trainer_state;
+  std::vector<float> values;
+
+  Checkpoint();
+
+  // copy the parameters and the optimizer state, the tensors are copied
+  // as they are and serialized later by the writer.
+  void snapshot(dynet::ParameterCollection& model, dynet::Trainer& trainer);
+
+  // restore the parameters and the optimizer state into a model of the same
+  // architecture.
+  void restore(dynet::ParameterCollection& model, dynet::Trainer& trainer) const;
+
+  // return false if the file is missing, of another version or corrupted.
+  bool load(const std::string& filename);
+
+  friend class boost::serialization::access;
+  template <class Archive>
+  void serialize(Archive& ar, const unsigned version) {
+    ar & iter;
+    ar & position;
+    ar & logc;
+    ar & order;
+    ar & llh;
+    ar & best_f;
+    ar & best_proxy;
+    ar & n_stale_evals;
+    ar & rng_state;
+    ar & order_rng_state;
+    ar & learning_rate;
+    ar & updates;
+    ar & trainer_state;
+    ar & values;
+  }
+};
+
+// Write the checkpoints from a background thread, through a temporary file
+// and a rename, so the file is always a complete checkpoint. One write is
+// running at a time, a new write waits for the previous one.
+struct CheckpointWriter {
+  CheckpointWriter();
+  ~CheckpointWriter();
+
+  // take over the content of checkpoint and write it to filename.
+  void write(const std::string& filename, Checkpoint& checkpoint);
+
+  void wait();
+
+private:
+  std::thread worker;
+  Checkpoint pending;
+
+  CheckpointWriter(const CheckpointWriter&);
+  CheckpointWriter& operator = (const CheckpointWriter&);
+};
+
+#endif  //  end for CHECKPOINT_H
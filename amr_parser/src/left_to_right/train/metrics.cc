@@ -0,0 +1,93 @@
+#include "metrics.h"
+#include "logging.h"
+#include "sys_utils.h"
+#include "dynet/globals.h"
+#include "dynet/devices.h"
+#include <algorithm>
+
+TrainingMetrics::TrainingMetrics() {
+  reset();
+}
+
+void TrainingMetrics::open(const std::string& filename) {
+  if (filename.empty()) { return; }
+  ofs.open(filename, std::ios::app);
+  if (!ofs) {
+    _WARN << "Metrics:: failed to open " << filename << ", metrics are disabled.";
+    return;
+  }
+  _INFO << "Metrics:: write the training metrics to " << filename;
+  reset();
+}
+
+bool TrainingMetrics::enabled() const {
+  return ofs.is_open();
+}
+
+void TrainingMetrics::reset() {
+  interval_start = Clock::now();
+  n_sentences = 0;
+  n_actions = 0;
+  n_tokens = 0;
+  nodes.clear();
+  build_ms = forward_ms = backward_ms = update_ms = 0.;
+  peak_pool_bytes = 0;
+}
+
+double TrainingMetrics::elapsed_ms(const Clock::time_point& start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void TrainingMetrics::add_sentence(unsigned n_tokens_,
+                                   unsigned n_actions_,
+                                   unsigned n_nodes,
+                                   double build_ms_,
+                                   double forward_ms_,
+                                   double backward_ms_) {
+  ++n_sentences;
+  n_tokens += n_tokens_;
+  n_actions += n_actions_;
+  nodes.push(n_nodes);
+  build_ms += build_ms_;
+  forward_ms += forward_ms_;
+  backward_ms += backward_ms_;
+  // the forward (FXS) and backward (DEDS) pools hold the graph.
+  dynet::Device* device = dynet::default_device;
+  if (device != nullptr && device->pools.size() > 1) {
+    size_t used = device->pools[0]->used() + device->pools[1]->used();
+    peak_pool_bytes = std::max(peak_pool_bytes, used);
+  }
+}
+
+void TrainingMetrics::add_update(double update_ms_) {
+  update_ms += update_ms_;
+}
+
+void TrainingMetrics::report(unsigned iter, unsigned n_trained, float epoch, float loss) {
+  if (!enabled()) { return; }
+  double seconds = elapsed_ms(interval_start) / 1000.;
+  if (seconds <= 0.) { seconds = 1e-9; }
+  size_t rss = 0, peak_rss = 0;
+  get_memory_usage(rss, peak_rss);
+  const double kMB = 1024. * 1024.;
+
+  ofs << "{\"iter\": " << iter
+      << ", \"sentences\": " << n_trained
+      << ", \"epoch\": " << epoch
+      << ", \"loss\": " << loss
+      << ", \"seconds\": " << seconds
+      << ", \"sents_per_sec\": " << n_sentences / seconds
+      << ", \"actions_per_sec\": " << n_actions / seconds
+      << ", \"tokens_per_sec\": " << n_tokens / seconds
+      << ", \"nodes_mean\": " << nodes.mean()
+      << ", \"nodes_stdev\": " << nodes.stdev()
+      << ", \"build_ms\": " << build_ms
+      << ", \"forward_ms\": " << forward_ms
+      << ", \"backward_ms\": " << backward_ms
+      << ", \"update_ms\": " << update_ms
+      << ", \"pool_peak_mb\": " << peak_pool_bytes / kMB
+      << ", \"rss_mb\": " << rss / kMB
+      << ", \"peak_rss_mb\": " << peak_rss / kMB
+      << "}" << std::endl;
+  reset();
+}
@@ -0,0 +1,55 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include "math_utils.h"
+
+// The throughput and memory of the training between two reports, written
+// as one JSON object per line so the file can be tailed by the dashboards.
+// Each line has the sentences/actions/tokens per second, the mean and stdev
+// of the graph nodes per sentence, the time split into graph building,
+// forward, backward and update, the peak usage of the DyNet forward and
+// backward memory pools, and the RSS of the process.
+struct TrainingMetrics {
+  typedef std::chrono::high_resolution_clock Clock;
+
+  TrainingMetrics();
+
+  // write to filename, the metrics are not written if it is empty.
+  void open(const std::string& filename);
+  bool enabled() const;
+
+  // called before the graph of the sentence is released, so the memory
+  // pools still hold it.
+  void add_sentence(unsigned n_tokens,
+                    unsigned n_actions,
+                    unsigned n_nodes,
+                    double build_ms,
+                    double forward_ms,
+                    double backward_ms);
+  void add_update(double update_ms);
+
+  // write the line of the interval and start the next one.
+  void report(unsigned iter, unsigned n_trained, float epoch, float loss);
+
+  static double elapsed_ms(const Clock::time_point& start);
+
+private:
+  void reset();
+
+  std::ofstream ofs;
+  Clock::time_point interval_start;
+  unsigned n_sentences;
+  unsigned long n_actions;
+  unsigned long n_tokens;
+  MeanStdevStreamer nodes;
+  double build_ms;
+  double forward_ms;
+  double backward_ms;
+  double update_ms;
+  size_t peak_pool_bytes;
+};
+
+#endif  //  end for METRICS_H
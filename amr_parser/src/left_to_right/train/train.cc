@@ -1,33 +1,176 @@
-#include "train.h"
-#include "logging.h"
-#include "evaluate/evaluate.h"
-
-Trainer::Trainer(const po::variables_map & conf) {
-  gamma = conf["gamma"].as<float>();
-  _INFO << "RL:: gamma = " << gamma;
-
-  lambda_ = conf["lambda"].as<float>();
-  _INFO << "RL:: lambda = " << lambda_;
-}
-
-void Trainer::eval(const po::variables_map& conf,
-                   const std::string & output,
-                   const std::string & model_name,
-                   float & current_best,
-                   Corpus & corpus,
-                   Parser & parser,
-                   bool update_and_save) {
-  float f = evaluate(conf, corpus, parser, output, true);
-  if (update_and_save && f > current_best) {
-    current_best = f;
-    dynet::save_dynet_model(model_name, (&(parser.model)));
-    f = evaluate(conf, corpus, parser, output, false);
-    _INFO << "Trainer:: new best record achieved " << current_best << ", test: " << f;
-  }
-}
-
-dynet::Expression Trainer::l2(Parser & parser, unsigned n) {
-  std::vector<dynet::Expression> reg;
-  for (auto e : parser.get_params()) { reg.push_back(dynet::squared_norm(e)); }
-  return (0.5 * n) * lambda_ * dynet::sum(reg);
-}
+#include "train.h"
+#include "logging.h"
+#include "sys_utils.h"
+#include "trace_utils.h"
+#include "evaluate/evaluate.h"
+#include <cstdio>
+#include <iostream>
+#include <boost/lexical_cast.hpp>
+#ifndef _MSC_VER
+#include <poll.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+namespace {
+
+/// The message from the evaluating child, saved is set if f beats the best.
+struct EvalResult {
+  float f;
+  float test_f;
+  int saved;
+};
+
+}
+
+Trainer::Trainer(const po::variables_map & conf) :
+  async_eval(false), eval_pid(-1), eval_fd(-1),
+  best_proxy(-1.f), n_stale_evals(0), stop_training(false) {
+  gamma = conf["gamma"].as<float>();
+  _INFO << "RL:: gamma = " << gamma;
+
+  lambda_ = conf["lambda"].as<float>();
+  _INFO << "RL:: lambda = " << lambda_;
+
+#ifndef _MSC_VER
+  async_eval = (conf.count("async_eval") > 0);
+#else
+  if (conf.count("async_eval")) {
+    _WARN << "RL:: asynchronous evaluation is not supported on this platform.";
+  }
+#endif
+  if (async_eval) { _INFO << "RL:: evaluate in the background."; }
+
+  proxy_devel = conf["proxy_devel"].as<unsigned>();
+  proxy_margin = conf["proxy_margin"].as<float>();
+  patience = conf["patience"].as<unsigned>();
+  if (proxy_devel > 0) {
+    _INFO << "RL:: proxy evaluation on " << proxy_devel << " sentences, margin = " << proxy_margin
+      << ", patience = " << patience;
+  } else if (patience > 0) {
+    _WARN << "RL:: --patience needs --proxy_devel, ignored.";
+    patience = 0;
+  }
+}
+
+void Trainer::eval_and_save(const po::variables_map& conf,
+                            const std::string & output,
+                            const std::string & model_name,
+                            float current_best,
+                            Corpus & corpus,
+                            Parser & parser,
+                            bool update_and_save,
+                            float & f,
+                            float & test_f) {
+  f = evaluate(conf, corpus, parser, output, true);
+  test_f = -1.f;
+  if (update_and_save && f > current_best) {
+    // save to a temporary file first, the model is never left half-written.
+    TraceSpan span("save_model", "train");
+    std::string tmp_file = model_name + ".tmp." + boost::lexical_cast<std::string>(portable_getpid());
+    dynet::save_dynet_model(tmp_file, (&(parser.model)));
+    int renamed = std::rename(tmp_file.c_str(), model_name.c_str());
+    BOOST_ASSERT_MSG(renamed == 0, "Trainer:: failed to rename the saved model.");
+    span.end();
+    test_f = evaluate(conf, corpus, parser, output, false);
+  }
+}
+
+void Trainer::eval(const po::variables_map& conf,
+                   const std::string & output,
+                   const std::string & model_name,
+                   float & current_best,
+                   Corpus & corpus,
+                   Parser & parser,
+                   bool update_and_save) {
+  if (proxy_devel > 0 && update_and_save) {
+    if (proxy_sids.empty()) { get_proxy_devel(corpus, proxy_devel, proxy_sids); }
+    float p = evaluate_proxy(conf, corpus, parser, proxy_sids);
+    if (best_proxy >= 0.f && p <= best_proxy + proxy_margin) {
+      ++n_stale_evals;
+      _INFO << "Trainer:: proxy " << p << " does not beat " << best_proxy << " by " << proxy_margin
+        << ", skip the full evaluation (" << n_stale_evals << " in a row).";
+      if (patience > 0 && n_stale_evals >= patience) {
+        stop_training = true;
+        _INFO << "Trainer:: no improvement in " << patience << " evaluations, stop training.";
+      }
+      return;
+    }
+    best_proxy = p;
+    n_stale_evals = 0;
+  }
+
+  if (!async_eval) {
+    float f, test_f;
+    eval_and_save(conf, output, model_name, current_best, corpus, parser, update_and_save, f, test_f);
+    if (update_and_save && f > current_best) {
+      current_best = f;
+      _INFO << "Trainer:: new best record achieved " << current_best << ", test: " << test_f;
+    }
+    return;
+  }
+#ifndef _MSC_VER
+  // the child compares with the best record, so the previous one should finish.
+  collect_eval(current_best, true);
+
+  if (before_eval_fork) { before_eval_fork(); }
+
+  int fds[2];
+  int piped = pipe(fds);
+  BOOST_ASSERT_MSG(piped == 0, "Trainer:: failed to create the pipe.");
+  std::cout.flush();
+  std::cerr.flush();
+  std::fflush(nullptr);
+  stop_boost_log_for_fork();
+  int pid = fork();
+  BOOST_ASSERT_MSG(pid >= 0, "Trainer:: failed to fork the evaluation.");
+  restart_boost_log_after_fork();
+  if (pid == 0) {
+    close(fds[0]);
+    TraceRecorder::get().set_process_name("evaluation");
+    EvalResult result;
+    eval_and_save(conf, output, model_name, current_best, corpus, parser, update_and_save,
+                  result.f, result.test_f);
+    result.saved = (update_and_save && result.f > current_best);
+    ssize_t n = write(fds[1], &result, sizeof(result));
+    close(fds[1]);
+    TraceRecorder::get().close();
+    flush_boost_log();
+    std::cout.flush();
+    std::cerr.flush();
+    _exit(n == sizeof(result) ? 0 : 1);
+  }
+  close(fds[1]);
+  eval_fd = fds[0];
+  eval_pid = pid;
+#endif
+}
+
+bool Trainer::collect_eval(float & current_best, bool block) {
+#ifndef _MSC_VER
+  if (eval_pid < 0) { return true; }
+  if (!block) {
+    struct pollfd pfd;
+    pfd.fd = eval_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, 0) <= 0) { return false; }
+  }
+
+  EvalResult result;
+  ssize_t n = read(eval_fd, &result, sizeof(result));
+  close(eval_fd);
+  int status = 0;
+  waitpid(eval_pid, &status, 0);
+  eval_fd = -1;
+  eval_pid = -1;
+
+  if (n != sizeof(result)) {
+    _WARN << "Trainer:: the background evaluation exited abnormally.";
+  } else if (result.saved && result.f > current_best) {
+    current_best = result.f;
+    _INFO << "Trainer:: new best record achieved " << current_best << ", test: " << result.test_f;
+  }
+#endif
+  return true;
+}
@@ -1,35 +1,70 @@
-#ifndef TRAIN_H
-#define TRAIN_H
-
-#include <boost/program_options.hpp>
-#include "parser/parser.h"
-#include "corpus.h"
-namespace po = boost::program_options;
-
-struct Trainer {
-  float gamma;
-  float lambda_;
- 
-  Trainer(const po::variables_map& conf);
-
-  void eval(const po::variables_map& conf,
-            const std::string & output,
-            const std::string & model_name,
-            float & current_best,
-            Corpus & corpus,
-            Parser & parser,
-            bool update_and_save = true);
-
-  void eval(const po::variables_map& conf,
-            const std::string & output,
-            const std::string & model_name,
-            float & current_best,
-            Corpus & corpus,
-            Parser & parser,
-            Parser & parser2,
-            bool update_and_save = true);
-
-  dynet::Expression l2(Parser & parser, unsigned n);
-};
-
+#ifndef TRAIN_H
+#define TRAIN_H
+
+#include <functional>
+#include <boost/program_options.hpp>
+#include "parser/parser.h"
+#include "corpus.h"
+namespace po = boost::program_options;
+
+struct Trainer {
+  float gamma;
+  float lambda_;
+
+  // With async_eval, eval forks a child that evaluates the snapshot of the
+  // parameters (the copy-on-write pages of the fork) while the training
+  // goes on. The child saves the model if it beats current_best and sends
+  // the scores back through a pipe, one evaluation is running at a time.
+  bool async_eval;
+  int eval_pid;
+  int eval_fd;
+  std::function<void()> before_eval_fork;  // run in the parent before forking.
+
+  // With proxy_devel, eval first scores a fixed subset of proxy_devel
+  // development sentences with evaluate_proxy, and only runs the full
+  // evaluation if the proxy beats the one of the last full evaluation by
+  // proxy_margin. After patience evaluations in a row without that,
+  // stop_training is set.
+  unsigned proxy_devel;
+  float proxy_margin;
+  unsigned patience;
+  std::vector<unsigned> proxy_sids;
+  float best_proxy;
+  unsigned n_stale_evals;
+  bool stop_training;
+ 
+  Trainer(const po::variables_map& conf);
+
+  void eval(const po::variables_map& conf,
+            const std::string & output,
+            const std::string & model_name,
+            float & current_best,
+            Corpus & corpus,
+            Parser & parser,
+            bool update_and_save = true);
+
+  void eval(const po::variables_map& conf,
+            const std::string & output,
+            const std::string & model_name,
+            float & current_best,
+            Corpus & corpus,
+            Parser & parser,
+            Parser & parser2,
+            bool update_and_save = true);
+
+  // collect the result of the running evaluation and update current_best,
+  // return false if it is still running and block is false.
+  bool collect_eval(float & current_best, bool block);
+
+  void eval_and_save(const po::variables_map& conf,
+                     const std::string & output,
+                     const std::string & model_name,
+                     float current_best,
+                     Corpus & corpus,
+                     Parser & parser,
+                     bool update_and_save,
+                     float & f,
+                     float & test_f);
+};
+
 #endif  //  end for TRAIN_H
\ No newline at end of file
@@ -1,207 +1,431 @@
-#include "trainer_utils.h"
-#include "train_supervised.h"
-#include "logging.h"
-#include "evaluate/evaluate.h"
-
-po::options_description SupervisedTrainer::get_options() {
-  po::options_description cmd("Supervised options");
-  cmd.add_options()
-    ("supervised_oracle", po::value<std::string>()->default_value("static"), "The type of oracle in supervised learning [static|dynamic|pseduo_dynamic].")
-    ("supervised_objective", po::value<std::string>()->default_value("crossentropy"), "The learning objective [crossentropy|rank|bipartie_rank]")
-    ("supervised_do_pretrain_iter", po::value<unsigned>()->default_value(1), "The number of pretrain iteration on dynamic oracle.")
-    ("supervised_do_explore_prob", po::value<float>()->default_value(0.9), "The probability of exploration.")
-    ("supervised_pseudo_oracle_model", po::value<std::string>(), "The path to the pseudo dynamic oracle model, must in pseduo_dynamic mode.")
-    ;
-  return cmd;
-}
-
-SupervisedTrainer::SupervisedTrainer(const po::variables_map& conf, Parser * p) :
-  Trainer(conf), 
-  parser(p),
-  pseudo_dynamic_oracle(nullptr),
-  pseudo_dynamic_oracle_model(nullptr) {
-  if (conf["supervised_oracle"].as<std::string>() == "static") {
-    oracle_type = kStatic;
-  } else {
-    _ERROR << "Unknown oracle :" << conf["supervised_oracle"].as<std::string>();
-  }
-
-  if (conf["supervised_objective"].as<std::string>() == "crossentropy") {
-    objective_type = kCrossEntropy;
-  } else if (conf["supervised_objective"].as<std::string>() == "rank") {
-    objective_type = kRank;
-  } else {
-    objective_type = kBipartieRank;
-  }
-  lambda_ = conf["lambda"].as<float>();
-  _INFO << "SUP:: learning objective " << conf["supervised_objective"].as<std::string>();
-  
-  system = conf["system"].as<std::string>();
-}
-
-void SupervisedTrainer::train(const po::variables_map& conf,
-                              Corpus& corpus,
-                              const std::string& name,
-                              const std::string& output) {
-  dynet::ParameterCollection& model = parser->model;
-  _INFO << "SUP:: start lstm-parser supervised training.";
-
-  dynet::Trainer* trainer = get_trainer(conf, model);
-  // unsigned kUNK = corpus.get_or_add_word(Corpus::UNK);
-  unsigned max_iter = conf["max_iter"].as<unsigned>();
-
-  float llh = 0.f;
-  float llh_in_batch = 0.f;
-  float best_f = 0.f;
-
-  std::vector<unsigned> order;
-  get_orders(corpus, order);
-  float n_train = order.size();
-
-  unsigned logc = 0;
-  // unsigned unk_strategy = conf["unk_strategy"].as<unsigned>();
-  // float unk_prob = conf["unk_prob"].as<float>();
-  unsigned report_stops = conf["report_stops"].as<unsigned>();
-  unsigned evaluate_stops = conf["evaluate_stops"].as<unsigned>();
-  unsigned evaluate_skips = conf["evaluate_skips"].as<unsigned>();
-  float eta0 = trainer->learning_rate;
-
-  _INFO << "SUP:: will stop after " << max_iter << " iterations.";
-  for (unsigned iter = 0; iter < max_iter; ++iter) {
-    llh = 0;
-    _INFO << "SUP:: start training iteration #" << iter << ", shuffled.";
-    std::shuffle(order.begin(), order.end(), (*dynet::rndeng));
-
-    for (unsigned sid : order) {
-      _TRACE << "sid=" << sid;
-      InputUnits& input_units = corpus.training_inputs[sid];
-      const ActionUnits& parse_units = corpus.training_actions[sid];
-      //random_replace_singletons(unk_strategy, unk_prob, corpus.singleton, kUNK, input_units);
-      
-      float lp;
-      
-      lp = train_on_one_full_tree(input_units, parse_units, trainer, iter);
-      
-      llh += lp;
-      llh_in_batch += lp;
-      //restore_singletons(unk_strategy, input_units);
-
-      ++logc;
-      if (logc % report_stops == 0) {
-        float epoch = (float(logc) / n_train);
-        _INFO << "SUP:: iter #" << iter << " (epoch " << epoch << ") loss " << llh_in_batch;
-        llh_in_batch = 0.f;
-      }
-      if (iter >= evaluate_skips && logc % evaluate_stops == 0) {
-        eval(conf, output, name, best_f, corpus, *parser);
-      }
-    }
-
-    _INFO << "SUP:: end of iter #" << iter << " loss " << llh;
-    eval(conf, output, name, best_f, corpus, *parser);
-
-    update_trainer(conf, eta0, float(iter), trainer);
-    trainer->status();
-  }
-
-  delete trainer;
-}
-
-float SupervisedTrainer::train_on_one_full_tree(const InputUnits& input_units,
-                                                const ActionUnits& action_units,
-                                                dynet::Trainer* trainer,
-                                                unsigned iter) {
-  dynet::ComputationGraph cg;
-  parser->activate_training();
-  parser->new_graph(cg);
-  
-  std::vector<dynet::Expression> loss;
-
-  unsigned len = input_units.size();
-  //for (int i = 0; i < len; i++) {
-  //  std::cerr << input_units[i].w_str << " ";
-  //}
-  //std::cerr << std::endl;
-  State state(len);
-  parser->initialize(cg, input_units, state);
-
-  unsigned illegal_action = parser->sys.num_actions();
-  unsigned n_actions = 0;
-  while (!state.terminated()) {
-    // collect all valid actions.
-    std::vector<unsigned> valid_actions;
-    parser->sys.get_valid_actions(state, valid_actions);
-
-    dynet::Expression score_exprs = parser->get_scores();
-    std::vector<float> scores = dynet::as_vector(cg.get_value(score_exprs));
-    unsigned action = 0;
-
-    unsigned best_gold_action = illegal_action;
-    unsigned worst_gold_action = illegal_action;
-    unsigned best_non_gold_action = illegal_action;
-
-    best_gold_action = action_units[n_actions].aid;
-    //std::cerr << action_units[n_actions].a_str << std::endl;
-    action = action_units[n_actions].aid;
-
-    if (objective_type == kRank || objective_type == kBipartieRank) {
-      float best_non_gold_action_score = -1e10;
-      for (unsigned i = 0; i < valid_actions.size(); ++i) {
-        unsigned act = valid_actions[i];
-        if (act != best_gold_action && (scores[act] > best_non_gold_action_score)) {
-          best_non_gold_action = act;
-          best_non_gold_action_score = scores[act];
-        }
-      }
-    }
-
-    if (objective_type == kCrossEntropy) {
-      loss.push_back(dynet::pickneglogsoftmax(score_exprs, best_gold_action));
-    } else if (objective_type == kRank) {
-      if (best_gold_action != illegal_action && best_non_gold_action != illegal_action) {
-        loss.push_back(dynet::pairwise_rank_loss(
-          dynet::pick(score_exprs, best_gold_action),
-          dynet::pick(score_exprs, best_non_gold_action)
-        ));
-      }
-    } else {
-      if (worst_gold_action != illegal_action && best_non_gold_action != illegal_action) {
-        loss.push_back(dynet::pairwise_rank_loss(
-          dynet::pick(score_exprs, worst_gold_action),
-          dynet::pick(score_exprs, best_non_gold_action)
-        ));
-      }
-    }
-
-    //CONFIRM
-    if (action == 0 && best_gold_action == 0) {
-      dynet::Expression confirm_scores_expr;
-      if (system == "eager") {
-        confirm_scores_expr = parser->get_confirm_values(state.buffer.back().first);
-      } else if (system == "swap") {
-        confirm_scores_expr = parser->get_confirm_values(state.stack.back().first);
-      } else {
-        BOOST_ASSERT_MSG(false, "Illegal System");
-      }
-      //std::cerr << confirm_scores_expr.dim()[0] << " " << confirm_scores_expr.dim()[1] << std::endl;
-      //std::cerr << "~" << action_units[n_actions].idx << " " << state.stack.back().first << " " << state.stack.back().second << std::endl;
-      //std::cerr << action_units[n_actions].idx << std::endl;
-      loss.push_back(dynet::pickneglogsoftmax(confirm_scores_expr, action_units[n_actions].idx));
-      //std::cerr << action_units[n_actions].idx << std::endl;
-    }
-
-    parser->perform_action(action, cg, state);
-    n_actions++;
-  }
-  float ret = 0.f;
-  if (loss.size() > 0) {
-    std::vector<dynet::Expression> all_params = parser->get_params();
-    std::vector<dynet::Expression> reg;
-    for (auto e : all_params) { reg.push_back(dynet::squared_norm(e)); }
-    dynet::Expression l = dynet::sum(loss) + 0.5 * loss.size() * lambda_ * dynet::sum(reg);
-    ret = dynet::as_scalar(cg.incremental_forward(l));
-    cg.backward(l);
-    trainer->update();
-  }
-  return ret;
+#include "trainer_utils.h"
+#include "train_supervised.h"
+#include "logging.h"
+#include "evaluate/evaluate.h"
+#include "parallel_utils.h"
+#include "trace_utils.h"
+#include "checkpoint.h"
+#include <algorithm>
+#include <sstream>
+#include <boost/algorithm/string.hpp>
+
+po::options_description SupervisedTrainer::get_options() {
+  po::options_description cmd("Supervised options");
+  cmd.add_options()
+    ("supervised_oracle", po::value<std::string>()->default_value("static"), "The type of oracle in supervised learning [static|dynamic|pseduo_dynamic].")
+    ("supervised_objective", po::value<std::string>()->default_value("crossentropy"), "The learning objective [crossentropy|rank|bipartie_rank]")
+    ("supervised_do_pretrain_iter", po::value<unsigned>()->default_value(1), "The number of pretrain iteration on dynamic oracle.")
+    ("supervised_do_explore_prob", po::value<float>()->default_value(0.9), "The probability of exploration.")
+    ("supervised_pseudo_oracle_model", po::value<std::string>(), "The path to the pseudo dynamic oracle model, must in pseduo_dynamic mode.")
+    ;
+  return cmd;
+}
+
+SupervisedTrainer::SupervisedTrainer(const po::variables_map& conf, Parser * p) :
+  Trainer(conf), 
+  parser(p),
+  pseudo_dynamic_oracle(nullptr),
+  pseudo_dynamic_oracle_model(nullptr) {
+  if (conf["supervised_oracle"].as<std::string>() == "static") {
+    oracle_type = kStatic;
+  } else {
+    _ERROR << "Unknown oracle :" << conf["supervised_oracle"].as<std::string>();
+  }
+
+  if (conf["supervised_objective"].as<std::string>() == "crossentropy") {
+    objective_type = kCrossEntropy;
+  } else if (conf["supervised_objective"].as<std::string>() == "rank") {
+    objective_type = kRank;
+  } else {
+    objective_type = kBipartieRank;
+  }
+  lambda_ = conf["lambda"].as<float>();
+  batch_size = std::max(1u, conf["batch_size"].as<unsigned>());
+  _INFO << "SUP:: learning objective " << conf["supervised_objective"].as<std::string>();
+  _INFO << "SUP:: update after every " << batch_size << " sentences.";
+  
+  system = conf["system"].as<std::string>();
+}
+
+void SupervisedTrainer::train(const po::variables_map& conf,
+                              Corpus& corpus,
+                              const std::string& name,
+                              const std::string& output) {
+  dynet::ParameterCollection& model = parser->model;
+  _INFO << "SUP:: start lstm-parser supervised training.";
+
+  dynet::Trainer* trainer = get_trainer(conf, model);
+  unsigned n_workers = std::max(1u, conf["workers"].as<unsigned>());
+  const bool hogwild = (n_workers > 1 && conf.count("hogwild"));
+  // L2 as decoupled weight decay: DyNet keeps a global scale that shrinks by
+  // (1 - lambda) at every update and folds it into the values lazily. The
+  // scale is private to a process, so it does not apply to shared values.
+  if (lambda_ > 0.f && hogwild) {
+    _WARN << "SUP:: weight decay is not supported with --hogwild, ignored.";
+  } else if (lambda_ > 0.f) {
+    model.set_weight_decay_lambda(lambda_);
+    _INFO << "SUP:: weight decay = " << lambda_;
+  }
+  // unsigned kUNK = corpus.get_or_add_word(Corpus::UNK);
+  unsigned max_iter = conf["max_iter"].as<unsigned>();
+
+  float llh = 0.f;
+  float llh_in_batch = 0.f;
+  float best_f = 0.f;
+
+  std::vector<unsigned> order;
+  TrainingStream* stream = nullptr;
+  if (conf.count("stream_training")) {
+    std::vector<std::string> shards;
+    boost::algorithm::split(shards, conf["training_data"].as<std::string>(), boost::is_any_of(","));
+    stream = new TrainingStream(corpus, shards, conf["shuffle_buffer"].as<unsigned>());
+  } else {
+    get_orders(corpus, order);
+  }
+  float n_train = corpus.n_train;
+
+  unsigned logc = 0;
+  unsigned n_in_batch = 0;
+  // unsigned unk_strategy = conf["unk_strategy"].as<unsigned>();
+  // float unk_prob = conf["unk_prob"].as<float>();
+  unsigned report_stops = conf["report_stops"].as<unsigned>();
+  unsigned evaluate_stops = conf["evaluate_stops"].as<unsigned>();
+  unsigned evaluate_skips = conf["evaluate_skips"].as<unsigned>();
+  float eta0 = trainer->learning_rate;
+
+  // A checkpoint is written every checkpoint_stops sentences and at the end
+  // of each iteration. The stream only resumes from the start of an
+  // iteration, so it is only checkpointed at the end of the iterations.
+  // With several workers, worker 0 writes it right after an average, when
+  // all the workers hold the same parameters and have trained their share
+  // of the sentences before the position. They all resume from it, with the
+  // optimizer state of worker 0. The hogwild workers only meet at the end
+  // of an iteration.
+  std::string checkpoint_file = (conf.count("checkpoint") ? conf["checkpoint"].as<std::string>() : "");
+  unsigned checkpoint_stops = conf["checkpoint_stops"].as<unsigned>();
+  if (stream || hogwild) { checkpoint_stops = 0; }
+  std::mt19937 order_rng(conf["random_seed"].as<unsigned>());
+  CheckpointWriter checkpoint_writer;
+  // a running background evaluation can still save a better model, so its
+  // best_f is collected first. The end of an iteration waits for it, a
+  // checkpoint in the middle is put off until it is collected.
+  bool checkpoint_due = false;
+  auto save_checkpoint = [&](unsigned iter, unsigned position, bool block) {
+    if (!collect_eval(best_f, block)) {
+      checkpoint_due = true;
+      return;
+    }
+    checkpoint_due = false;
+    Checkpoint checkpoint;
+    checkpoint.iter = iter;
+    checkpoint.position = position;
+    checkpoint.logc = logc;
+    checkpoint.order = order;
+    checkpoint.llh = llh;
+    checkpoint.best_f = best_f;
+    checkpoint.best_proxy = best_proxy;
+    checkpoint.n_stale_evals = n_stale_evals;
+    std::ostringstream os;
+    os << (*dynet::rndeng);
+    checkpoint.rng_state = os.str();
+    std::ostringstream order_os;
+    order_os << order_rng;
+    checkpoint.order_rng_state = order_os.str();
+    TraceSpan span("snapshot_checkpoint", "checkpoint");
+    checkpoint.snapshot(model, (*trainer));
+    checkpoint_writer.write(checkpoint_file, checkpoint);
+  };
+
+  unsigned start_iter = 0;
+  unsigned start_position = 0;
+  if (conf.count("resume")) {
+    Checkpoint checkpoint;
+    if (checkpoint_file.empty() || !checkpoint.load(checkpoint_file)) {
+      _WARN << "SUP:: no checkpoint to resume from, start from scratch.";
+    } else {
+      BOOST_ASSERT_MSG(stream || checkpoint.order.size() == order.size(),
+                       "SUP:: the checkpoint does not match the training data.");
+      checkpoint.restore(model, (*trainer));
+      start_iter = checkpoint.iter;
+      start_position = checkpoint.position;
+      logc = checkpoint.logc;
+      if (!stream) { order = checkpoint.order; }
+      llh = checkpoint.llh;
+      best_f = checkpoint.best_f;
+      best_proxy = checkpoint.best_proxy;
+      n_stale_evals = checkpoint.n_stale_evals;
+      std::istringstream is(checkpoint.rng_state);
+      is >> (*dynet::rndeng);
+      std::istringstream order_is(checkpoint.order_rng_state);
+      order_is >> order_rng;
+      _INFO << "SUP:: resumed from " << checkpoint_file << " at iter #" << start_iter
+        << ", sentence " << start_position << ", best " << best_f;
+    }
+  }
+
+  // With several workers, worker r trains on the sentences i with
+  // i % n_workers == r. All the workers walk the same sequence, so the
+  // shuffling has its own generator seeded the same in every worker, and
+  // they average the parameters after every sync_stops * n_workers
+  // sentences. Worker 0 evaluates and saves the model after a sync.
+  // With hogwild, the workers update the same shared parameters instead,
+  // they only wait for each other at the end of an iteration.
+  ParameterAverager averager;
+  unsigned sync_stops = std::max(1u, conf["sync_stops"].as<unsigned>());
+  std::mt19937& shuffle_rng = (n_workers > 1 ? order_rng : (*dynet::rndeng));
+  if (n_workers > 1) {
+    averager.init(model, n_workers, hogwild);
+    n_workers = averager.n_workers;
+  }
+  if (n_workers > 1) {
+    unsigned rank = averager.fork_workers();
+    if (rank > 0) { dynet::rndeng->seed(conf["random_seed"].as<unsigned>() + rank); }
+    _INFO << "SUP:: worker " << rank << " of " << n_workers << " started, average after every "
+      << sync_stops << " sentences.";
+  }
+  const bool is_master = (averager.rank == 0);
+  // the checkpoint writer logs, the fork should not copy it in the middle of a record.
+  before_eval_fork = [&checkpoint_writer]() { checkpoint_writer.wait(); };
+  unsigned n_seen = 0;
+
+  // the early stop of worker 0 reaches the other workers in the next average.
+  // With hogwild, the evaluation (and the forked one) decodes and saves a
+  // private snapshot of the shared values, which the other workers go on
+  // updating.
+  auto evaluate_now = [&]() {
+    if (hogwild) { averager.unshare(); }
+    eval(conf, output, name, best_f, corpus, *parser);
+    if (hogwild) { averager.reshare(model); }
+    if (stop_training) { averager.request_stop(); }
+  };
+  auto should_stop = [&]() { return (n_workers > 1 ? averager.stopped : stop_training); };
+
+  if (is_master && conf.count("metrics_file")) { metrics.open(conf["metrics_file"].as<std::string>()); }
+
+  auto flush_batch = [&]() {
+    if (n_in_batch > 0) {
+      TrainingMetrics::Clock::time_point start = TrainingMetrics::Clock::now();
+      TraceSpan span("update", "train");
+      trainer->update();
+      metrics.add_update(TrainingMetrics::elapsed_ms(start));
+      n_in_batch = 0;
+    }
+  };
+
+  _INFO << "SUP:: will stop after " << max_iter << " iterations.";
+  for (unsigned iter = start_iter; iter < max_iter; ++iter) {
+    // a checkpoint in the middle of iter keeps its shuffled order.
+    const unsigned first = (iter == start_iter ? start_position : 0);
+    if (first == 0) {
+      llh = 0;
+      _INFO << "SUP:: start training iteration #" << iter << ", shuffled.";
+      if (stream) {
+        stream->reset(shuffle_rng);
+      } else {
+        std::shuffle(order.begin(), order.end(), shuffle_rng);
+      }
+    } else {
+      _INFO << "SUP:: continue training iteration #" << iter << " from sentence " << first << ".";
+    }
+
+    InputUnits input_units;
+    ActionUnits parse_units;
+    for (unsigned i = first; ; ++i) {
+      if (stream) {
+        if (!stream->next(shuffle_rng, input_units, parse_units)) { break; }
+      } else {
+        if (i == order.size()) { break; }
+        unsigned sid = order[i];
+        _TRACE_HOT << "sid=" << sid;
+        input_units = corpus.training_inputs[sid];
+        parse_units = corpus.training_actions[sid];
+      }
+      ++n_seen;
+
+      if (i % n_workers == averager.rank) {
+        //input_units = random_replace_singletons(unk_strategy, unk_prob, corpus.singleton, kUNK, input_units, wids);
+        
+        float lp;
+        TraceSpan span("train_sentence", "train");
+        span.add_arg("tokens", input_units.size() - 1);
+        lp = train_on_one_full_tree(input_units, parse_units, iter);
+        span.end();
+        
+        llh += lp;
+        llh_in_batch += lp;
+
+        ++logc;
+        if (++n_in_batch == batch_size) { flush_batch(); }
+        if (logc % report_stops == 0) {
+          float epoch = (float(logc) * n_workers / n_train);
+          if (is_master) { _INFO << "SUP:: iter #" << iter << " (epoch " << epoch << ") loss " << llh_in_batch; }
+          metrics.report(iter, logc, epoch, llh_in_batch);
+          llh_in_batch = 0.f;
+          if (is_master) { collect_eval(best_f, false); }
+        }
+        if (n_workers == 1 && iter >= evaluate_skips && logc % evaluate_stops == 0) {
+          evaluate_now();
+          if (should_stop()) { break; }
+        }
+        if (n_workers == 1 && !checkpoint_file.empty() &&
+            ((checkpoint_due && n_in_batch == 0) || (checkpoint_stops > 0 && logc % checkpoint_stops == 0))) {
+          // the gradients of a partial batch are not kept in the checkpoint.
+          flush_batch();
+          save_checkpoint(iter, i + 1, false);
+        }
+      }
+
+      if (hogwild) {
+        if (is_master && iter >= evaluate_skips && n_seen % evaluate_stops == 0) {
+          evaluate_now();
+        }
+      } else if (n_workers > 1 && n_seen % (sync_stops * n_workers) == 0) {
+        flush_batch();
+        averager.average(model);
+        if (should_stop()) { break; }
+        unsigned n_synced = sync_stops * n_workers;
+        if (is_master && iter >= evaluate_skips && n_seen / evaluate_stops != (n_seen - n_synced) / evaluate_stops) {
+          evaluate_now();
+        }
+        if (is_master && !checkpoint_file.empty() && (checkpoint_due || (checkpoint_stops > 0 &&
+            n_seen / checkpoint_stops != (n_seen - n_synced) / checkpoint_stops))) {
+          save_checkpoint(iter, i + 1, false);
+        }
+      }
+    }
+
+    // flush the gradients of the last partial batch.
+    flush_batch();
+    averager.average(model);
+    if (should_stop()) {
+      _INFO << "SUP:: early stopped in iter #" << iter;
+      break;
+    }
+    if (is_master) {
+      _INFO << "SUP:: end of iter #" << iter << " loss " << llh;
+      evaluate_now();
+    }
+
+    update_trainer(conf, eta0, float(iter), trainer);
+    if (is_master) { trainer->status(); }
+    if (is_master && !checkpoint_file.empty()) { save_checkpoint(iter + 1, 0, true); }
+    if (should_stop()) {
+      _INFO << "SUP:: early stopped after iter #" << iter;
+      break;
+    }
+  }
+
+  if (is_master) { collect_eval(best_f, true); }
+  checkpoint_writer.wait();
+  delete stream;
+  delete trainer;
+  averager.finish();
+}
+
+float SupervisedTrainer::train_on_one_full_tree(const InputUnits& input_units,
+                                                const ActionUnits& action_units,
+                                                unsigned iter) {
+  TrainingMetrics::Clock::time_point start = TrainingMetrics::Clock::now();
+  dynet::ComputationGraph cg;
+  parser->activate_training();
+  parser->new_graph(cg);
+  
+  std::vector<dynet::Expression> loss;
+
+  unsigned len = input_units.size();
+  //for (int i = 0; i < len; i++) {
+  //  std::cerr << input_units[i].w_str << " ";
+  //}
+  //std::cerr << std::endl;
+  State state(len);
+  parser->initialize(cg, input_units, state);
+
+  unsigned illegal_action = parser->sys.num_actions();
+  unsigned n_actions = 0;
+  while (!state.terminated()) {
+    dynet::Expression score_exprs = parser->get_scores();
+
+    // only the rank objectives look at the scores of the valid actions. The
+    // cross-entropy follows the gold actions, so the graph of the whole
+    // sequence is built and evaluated in one forward at the end.
+    std::vector<unsigned> valid_actions;
+    std::vector<float> scores;
+    if (objective_type != kCrossEntropy) {
+      parser->sys.get_valid_actions(state, valid_actions);
+      scores = dynet::as_vector(cg.get_value(score_exprs));
+    }
+    unsigned action = 0;
+
+    unsigned best_gold_action = illegal_action;
+    unsigned worst_gold_action = illegal_action;
+    unsigned best_non_gold_action = illegal_action;
+
+    best_gold_action = action_units[n_actions].aid;
+    //std::cerr << action_units[n_actions].a_str << std::endl;
+    action = action_units[n_actions].aid;
+
+    if (objective_type == kRank || objective_type == kBipartieRank) {
+      float best_non_gold_action_score = -1e10;
+      for (unsigned i = 0; i < valid_actions.size(); ++i) {
+        unsigned act = valid_actions[i];
+        if (act != best_gold_action && (scores[act] > best_non_gold_action_score)) {
+          best_non_gold_action = act;
+          best_non_gold_action_score = scores[act];
+        }
+      }
+    }
+
+    if (objective_type == kCrossEntropy) {
+      loss.push_back(dynet::pickneglogsoftmax(score_exprs, best_gold_action));
+    } else if (objective_type == kRank) {
+      if (best_gold_action != illegal_action && best_non_gold_action != illegal_action) {
+        loss.push_back(dynet::pairwise_rank_loss(
+          dynet::pick(score_exprs, best_gold_action),
+          dynet::pick(score_exprs, best_non_gold_action)
+        ));
+      }
+    } else {
+      if (worst_gold_action != illegal_action && best_non_gold_action != illegal_action) {
+        loss.push_back(dynet::pairwise_rank_loss(
+          dynet::pick(score_exprs, worst_gold_action),
+          dynet::pick(score_exprs, best_non_gold_action)
+        ));
+      }
+    }
+
+    //CONFIRM
+    if (action == 0 && best_gold_action == 0) {
+      dynet::Expression confirm_scores_expr;
+      if (system == "eager") {
+        confirm_scores_expr = parser->get_confirm_values(state.buffer.back().first);
+      } else if (system == "swap") {
+        confirm_scores_expr = parser->get_confirm_values(state.stack.back().first);
+      } else {
+        BOOST_ASSERT_MSG(false, "Illegal System");
+      }
+      //std::cerr << confirm_scores_expr.dim()[0] << " " << confirm_scores_expr.dim()[1] << std::endl;
+      //std::cerr << "~" << action_units[n_actions].idx << " " << state.stack.back().first << " " << state.stack.back().second << std::endl;
+      //std::cerr << action_units[n_actions].idx << std::endl;
+      loss.push_back(dynet::pickneglogsoftmax(confirm_scores_expr, action_units[n_actions].idx));
+      //std::cerr << action_units[n_actions].idx << std::endl;
+    }
+
+    parser->perform_action(action, cg, state);
+    n_actions++;
+  }
+  float ret = 0.f;
+  double build_ms = TrainingMetrics::elapsed_ms(start);
+  double forward_ms = 0., backward_ms = 0.;
+  if (loss.size() > 0) {
+    dynet::Expression l = dynet::sum(loss);
+    start = TrainingMetrics::Clock::now();
+    ret = dynet::as_scalar(cg.incremental_forward(l));
+    forward_ms = TrainingMetrics::elapsed_ms(start);
+    start = TrainingMetrics::Clock::now();
+    cg.backward(l);
+    backward_ms = TrainingMetrics::elapsed_ms(start);
+  }
+  // the tokens do not count the ROOT guard, as in LatencyStats.
+  metrics.add_sentence(len - 1, n_actions, cg.nodes.size(), build_ms, forward_ms, backward_ms);
+  return ret;
 }
\ No newline at end of file
@@ -1,35 +1,97 @@
-#include "logging.h"
-#include <boost/log/core.hpp>
-#include <boost/log/trivial.hpp>
-#include <boost/log/expressions.hpp>
-#include <boost/log/utility/setup/console.hpp>
-#include <boost/log/utility/setup/common_attributes.hpp>
-#include <boost/log/support/date_time.hpp>
-
-
-void init_boost_log(bool verbose) {
-  namespace logging = boost::log;
-  namespace src = boost::log::sources;
-  namespace expr = boost::log::expressions;
-  namespace keywords = boost::log::keywords;
-
-  logging::add_console_log(
-    std::clog,
-    keywords::format = (
-    expr::stream
-    << expr::format_date_time< boost::posix_time::ptime >(
-    "TimeStamp",
-    "%Y-%m-%d %H:%M:%S")
-    << " [" << logging::trivial::severity << "] "
-    << expr::smessage
-    )
-    );
-
-  if (verbose) {
-    logging::core::get()->set_filter(logging::trivial::severity >= logging::trivial::trace);
-  } else {
-    logging::core::get()->set_filter(logging::trivial::severity > logging::trivial::trace);
-  }
-
-  logging::add_common_attributes();
-}
+#include "logging.h"
+#include <algorithm>
+#include <cstdlib>
+#include <boost/log/core.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/log/expressions.hpp>
+#include <boost/log/sinks/async_frontend.hpp>
+#include <boost/log/sinks/text_ostream_backend.hpp>
+#include <boost/log/sinks/unbounded_fifo_queue.hpp>
+#include <boost/log/utility/setup/console.hpp>
+#include <boost/log/utility/setup/common_attributes.hpp>
+#include <boost/log/support/date_time.hpp>
+#include <boost/core/null_deleter.hpp>
+#include <boost/make_shared.hpp>
+
+boost::log::trivial::severity_level log_min_severity = boost::log::trivial::trace;
+unsigned log_every_n = 1;
+
+namespace {
+
+namespace logging = boost::log;
+namespace sinks = boost::log::sinks;
+namespace expr = boost::log::expressions;
+namespace keywords = boost::log::keywords;
+
+typedef sinks::asynchronous_sink<sinks::text_ostream_backend, sinks::unbounded_fifo_queue> AsyncSink;
+
+boost::shared_ptr<AsyncSink> async_sink;
+bool async_enabled = false;
+
+logging::formatter get_formatter() {
+  return (
+    expr::stream
+    << expr::format_date_time< boost::posix_time::ptime >(
+    "TimeStamp",
+    "%Y-%m-%d %H:%M:%S")
+    << " [" << logging::trivial::severity << "] "
+    << expr::smessage
+    );
+}
+
+void add_async_sink() {
+  boost::shared_ptr<sinks::text_ostream_backend> backend =
+    boost::make_shared<sinks::text_ostream_backend>();
+  backend->add_stream(boost::shared_ptr<std::ostream>(&std::clog, boost::null_deleter()));
+  // flushed by the background thread, off the path of the caller.
+  backend->auto_flush(true);
+
+  async_sink = boost::make_shared<AsyncSink>(backend);
+  async_sink->set_formatter(get_formatter());
+  logging::core::get()->add_sink(async_sink);
+}
+
+void stop_async_sink() {
+  if (!async_sink) { return; }
+  logging::core::get()->remove_sink(async_sink);
+  async_sink->stop();
+  async_sink->flush();
+  async_sink.reset();
+}
+
+}
+
+void init_boost_log(bool verbose, bool async, unsigned every_n) {
+  async_enabled = async;
+  if (async) {
+    add_async_sink();
+    std::atexit(stop_async_sink);
+  } else {
+    logging::add_console_log(std::clog, keywords::format = get_formatter());
+  }
+
+  if (verbose) {
+    logging::core::get()->set_filter(logging::trivial::severity >= logging::trivial::trace);
+    log_min_severity = logging::trivial::trace;
+  } else {
+    logging::core::get()->set_filter(logging::trivial::severity > logging::trivial::trace);
+    log_min_severity = logging::trivial::debug;
+  }
+  log_every_n = std::max(1u, every_n);
+
+  logging::add_common_attributes();
+}
+
+void flush_boost_log() {
+  if (async_sink) { async_sink->flush(); }
+}
+
+void stop_boost_log_for_fork() {
+  // drains the queue and joins the feeding thread, so no record is lost and
+  // the child inherits no sink whose thread it does not have.
+  stop_async_sink();
+}
+
+void restart_boost_log_after_fork() {
+  if (async_enabled && !async_sink) { add_async_sink(); }
+}
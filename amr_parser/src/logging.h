@@ -1,15 +1,49 @@
-#ifndef LOGGING_UTILS_H
-#define LOGGING_UTILS_H
-
-#include <boost/log/trivial.hpp>
-#define _TRACE BOOST_LOG_TRIVIAL(trace)
-#define _DEBUG BOOST_LOG_TRIVIAL(debug)
-#define _INFO  BOOST_LOG_TRIVIAL(info)
-#define _WARN  BOOST_LOG_TRIVIAL(warning)
-#define _ERROR BOOST_LOG_TRIVIAL(error)
-
-
-void init_boost_log(bool verbose);
-
-
-#endif  //  end for LOGGING_UTILS_H
+#ifndef LOGGING_UTILS_H
+#define LOGGING_UTILS_H
+
+#include <atomic>
+#include <boost/log/trivial.hpp>
+
+// The lowest severity that passes the filter. It is compared before a record
+// is opened, so a filtered-out message costs one comparison and its stream
+// arguments are never evaluated.
+extern boost::log::trivial::severity_level log_min_severity;
+// A hot-path message is written once every log_every_n calls of its site.
+extern unsigned log_every_n;
+
+#define _LOG(severity) \
+  if (boost::log::trivial::severity < log_min_severity) {} \
+  else BOOST_LOG_TRIVIAL(severity)
+
+// the per-site counter lives in the lambda, each expansion has its own.
+#define _LOG_HOT(severity) \
+  if (boost::log::trivial::severity < log_min_severity) {} \
+  else if ([]() -> bool { static std::atomic<unsigned long> n_calls(0); \
+                          return (n_calls++ % log_every_n) != 0; }()) {} \
+  else BOOST_LOG_TRIVIAL(severity)
+
+#define _TRACE _LOG(trace)
+#define _DEBUG _LOG(debug)
+#define _INFO  _LOG(info)
+#define _WARN  _LOG(warning)
+#define _ERROR _LOG(error)
+
+// the rate-limited trace for the per-sentence or per-action messages.
+#define _TRACE_HOT _LOG_HOT(trace)
+
+
+// With async, the records are queued into a lock-free queue and written to
+// the console by a background thread; the queue is drained at exit.
+void init_boost_log(bool verbose, bool async = false, unsigned every_n = 1);
+
+// write the queued records, to be called before _exit.
+void flush_boost_log();
+
+// The background thread does not survive a fork, so the async sink is
+// stopped before fork() and restarted by both processes after it returns.
+// The records logged by other threads in between are dropped.
+void stop_boost_log_for_fork();
+void restart_boost_log_after_fork();
+
+
+#endif  //  end for LOGGING_UTILS_H
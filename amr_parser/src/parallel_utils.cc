@@ -0,0 +1,204 @@
+#include "parallel_utils.h"
+#include "logging.h"
+#include "trace_utils.h"
+#include "trainer_utils.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <boost/assert.hpp>
+#ifndef _MSC_VER
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#endif
+
+namespace {
+
+/// The header of the segment holds the barrier and the stop flag, the
+/// slots start after it.
+const size_t kHeaderSize = 256;
+
+#ifndef _MSC_VER
+struct SegmentHeader {
+  pthread_barrier_t barrier;
+  volatile int stop;
+};
+#endif
+
+/// Point the values and the row views of the lookup parameters to v.
+void set_lookup_values(dynet::LookupParameterStorage& p, float* v) {
+  p.all_values.v = v;
+  size_t row_size = p.dim.size();
+  for (size_t i = 0; i < p.values.size(); ++i) { p.values[i].v = v + i * row_size; }
+}
+
+}
+
+ParameterAverager::ParameterAverager() :
+  rank(0), n_workers(1), hogwild(false), stopped(false), n_floats(0), segment_size(0),
+  segment(nullptr), slots(nullptr), averaged(nullptr), shared_model(nullptr) {
+}
+
+ParameterAverager::~ParameterAverager() {
+  unshare();
+#ifndef _MSC_VER
+  if (segment != nullptr && rank == 0) {
+    pthread_barrier_destroy(&(static_cast<SegmentHeader*>(segment)->barrier));
+  }
+  if (segment != nullptr) { munmap(segment, segment_size); }
+#endif
+}
+
+void ParameterAverager::init(dynet::ParameterCollection& model, unsigned n, bool h) {
+#ifdef _MSC_VER
+  _WARN << "ParameterAverager:: multi-process training is not supported on this platform, use 1 worker.";
+  n_workers = 1;
+#else
+  BOOST_ASSERT_MSG(segment == nullptr, "ParameterAverager:: already initialized.");
+  BOOST_ASSERT_MSG(sizeof(SegmentHeader) <= kHeaderSize, "ParameterAverager:: the header of the segment is too small.");
+  n_workers = n;
+  hogwild = h;
+  n_floats = count_parameter_values(model);
+
+  size_t n_slots = (hogwild ? 1 : n_workers + 1);
+  segment_size = kHeaderSize + sizeof(float) * n_floats * n_slots;
+  segment = mmap(nullptr, segment_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  BOOST_ASSERT_MSG(segment != MAP_FAILED, "ParameterAverager:: failed to map the shared segment.");
+  slots = reinterpret_cast<float*>(static_cast<char*>(segment) + kHeaderSize);
+  averaged = slots + n_floats * (n_slots - 1);
+  if (hogwild) { share(model, true); }
+
+  static_cast<SegmentHeader*>(segment)->stop = 0;
+  pthread_barrierattr_t attr;
+  pthread_barrierattr_init(&attr);
+  pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+  pthread_barrier_init(&(static_cast<SegmentHeader*>(segment)->barrier), &attr, n_workers);
+  pthread_barrierattr_destroy(&attr);
+  _INFO << "ParameterAverager:: " << n_workers << " workers share " << n_floats << " parameters, "
+    << (segment_size >> 20) << "MB shared memory" << (hogwild ? ", hogwild." : ".");
+#endif
+}
+
+unsigned ParameterAverager::fork_workers() {
+#ifndef _MSC_VER
+  // the buffered output would be written once by every child otherwise.
+  std::cout.flush();
+  std::cerr.flush();
+  std::fflush(nullptr);
+  stop_boost_log_for_fork();
+  for (unsigned r = 1; r < n_workers; ++r) {
+    int pid = fork();
+    BOOST_ASSERT_MSG(pid >= 0, "ParameterAverager:: failed to fork the worker.");
+    if (pid == 0) {
+      restart_boost_log_after_fork();
+      rank = r;
+      children.clear();
+      TraceRecorder::get().set_process_name("worker " + std::to_string(r));
+      return rank;
+    }
+    children.push_back(pid);
+  }
+  restart_boost_log_after_fork();
+#endif
+  rank = 0;
+  return rank;
+}
+
+void ParameterAverager::share(dynet::ParameterCollection& model, bool copy_values) {
+  shared_model = &model;
+  float* out = averaged;
+  for (const auto& p : model.parameters_list()) {
+    size_t n = p->values.d.size();
+    if (copy_values) { std::memcpy(out, p->values.v, sizeof(float) * n); }
+    own_values.push_back(p->values.v);
+    p->values.v = out;
+    out += n;
+  }
+  for (const auto& p : model.lookup_parameters_list()) {
+    size_t n = p->all_values.d.size();
+    if (copy_values) { std::memcpy(out, p->all_values.v, sizeof(float) * n); }
+    own_values.push_back(p->all_values.v);
+    set_lookup_values(*p, out);
+    out += n;
+  }
+}
+
+void ParameterAverager::unshare() {
+  if (shared_model == nullptr) { return; }
+  unsigned k = 0;
+  for (const auto& p : shared_model->parameters_list()) {
+    std::memcpy(own_values[k], p->values.v, sizeof(float) * p->values.d.size());
+    p->values.v = own_values[k++];
+  }
+  for (const auto& p : shared_model->lookup_parameters_list()) {
+    std::memcpy(own_values[k], p->all_values.v, sizeof(float) * p->all_values.d.size());
+    set_lookup_values(*p, own_values[k++]);
+  }
+  own_values.clear();
+  shared_model = nullptr;
+}
+
+void ParameterAverager::reshare(dynet::ParameterCollection& model) {
+  BOOST_ASSERT_MSG(hogwild && shared_model == nullptr, "ParameterAverager:: nothing to reshare.");
+  // the other workers kept updating the segment, so it is not overwritten.
+  share(model, false);
+}
+
+void ParameterAverager::wait() {
+#ifndef _MSC_VER
+  pthread_barrier_wait(&(static_cast<SegmentHeader*>(segment)->barrier));
+#endif
+}
+
+void ParameterAverager::average(dynet::ParameterCollection& model) {
+  if (n_workers < 2) { return; }
+  TraceSpan span("average", "train");
+  if (!hogwild) { flatten_parameters(model, slots + n_floats * rank); }
+  wait();
+  // the flag is only written out of average, so every worker reads the same.
+  stopped = (static_cast<SegmentHeader*>(segment)->stop != 0);
+  if (hogwild) { wait(); return; }
+
+  size_t begin = n_floats * rank / n_workers;
+  size_t end = n_floats * (rank + 1) / n_workers;
+  std::memcpy(averaged + begin, slots + begin, sizeof(float) * (end - begin));
+  for (unsigned w = 1; w < n_workers; ++w) {
+    const float* slot = slots + n_floats * w;
+    for (size_t i = begin; i < end; ++i) { averaged[i] += slot[i]; }
+  }
+  float inv = 1.f / n_workers;
+  for (size_t i = begin; i < end; ++i) { averaged[i] *= inv; }
+  wait();
+
+  unflatten_parameters(averaged, model);
+}
+
+void ParameterAverager::request_stop() {
+#ifndef _MSC_VER
+  if (segment != nullptr) { static_cast<SegmentHeader*>(segment)->stop = 1; }
+#endif
+}
+
+void ParameterAverager::finish() {
+#ifndef _MSC_VER
+  if (rank > 0) {
+    TraceRecorder::get().close();
+    flush_boost_log();
+    std::cout.flush();
+    std::cerr.flush();
+    _exit(0);
+  }
+  for (int pid : children) {
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      _WARN << "ParameterAverager:: worker " << pid << " exited abnormally.";
+    }
+  }
+  children.clear();
+#endif
+  // the parent keeps the trained values after the segment is unmapped.
+  unshare();
+}
@@ -0,0 +1,73 @@
+#ifndef PARALLEL_UTILS_H
+#define PARALLEL_UTILS_H
+
+#include <vector>
+#include "dynet/model.h"
+
+// Data-parallel training with processes: the trainer forks n_workers - 1
+// children that share a memory segment, each worker trains its own copy of
+// the model and the copies are periodically replaced by their average
+// (model averaging). DyNet keeps one computation graph per process, so the
+// workers are processes rather than threads.
+//
+// Layout of the segment: a process-shared barrier and a stop flag, one slot
+// of the flattened parameters per worker and the slot of the average. Each
+// worker averages 1/n_workers of the parameters, so the reduction is spread
+// over the workers.
+//
+// In the hogwild mode, the segment holds a single copy of the parameters and
+// the values of the model are moved into it before the fork, so all the
+// workers update the same parameters without locks. The gradients and the
+// optimizer states stay private to each worker, and average only waits for
+// the other workers.
+struct ParameterAverager {
+  ParameterAverager();
+  ~ParameterAverager();
+
+  // allocate the segment for the model, must be called before fork_workers.
+  void init(dynet::ParameterCollection& model, unsigned n_workers, bool hogwild = false);
+
+  // fork the children, return the rank of the worker (0 for the parent).
+  unsigned fork_workers();
+
+  // replace the parameters with the average over the workers (or only wait
+  // for them in the hogwild mode). Every worker should call it the same
+  // number of times.
+  void average(dynet::ParameterCollection& model);
+
+  // ask all the workers to stop, stopped is set in the next average.
+  void request_stop();
+
+  // the children exit, the parent waits for them.
+  void finish();
+
+  // in the hogwild mode, give this process a private copy of the shared
+  // values, e.g. for a snapshot that the other workers do not modify.
+  void unshare();
+
+  // go back to the shared values after unshare, the private copy is dropped.
+  void reshare(dynet::ParameterCollection& model);
+
+  unsigned rank;
+  unsigned n_workers;
+  bool hogwild;
+  bool stopped;
+
+private:
+  void wait();
+  void share(dynet::ParameterCollection& model, bool copy_values);
+
+  size_t n_floats;
+  size_t segment_size;
+  void* segment;
+  float* slots;
+  float* averaged;
+  std::vector<int> children;
+  dynet::ParameterCollection* shared_model;
+  std::vector<float*> own_values;   // the private values replaced in the hogwild mode.
+
+  ParameterAverager(const ParameterAverager&);
+  ParameterAverager& operator = (const ParameterAverager&);
+};
+
+#endif  //  end for PARALLEL_UTILS_H
@@ -0,0 +1,73 @@
+#include "profile_utils.h"
+#include "sys_utils.h"
+#include <algorithm>
+#include <iomanip>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+uint64_t read_timestamp() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+Profiler::Profiler() :
+  start_ticks(read_timestamp()), start_time(std::chrono::steady_clock::now()) {
+}
+
+Profiler::~Profiler() {
+  report(std::cerr);
+}
+
+Profiler& Profiler::get() {
+  static Profiler profiler;
+  return profiler;
+}
+
+ProfileCounter* Profiler::counter(const std::string& name) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto found = index.find(name);
+  if (found != index.end()) { return found->second; }
+  ProfileCounter counter = { name, 0, 0 };
+  counters.push_back(counter);
+  index[name] = &counters.back();
+  return &counters.back();
+}
+
+void Profiler::report(std::ostream& os) {
+  std::lock_guard<std::mutex> lock(mutex);
+  std::vector<const ProfileCounter*> used;
+  for (const ProfileCounter& counter : counters) {
+    if (counter.calls > 0) { used.push_back(&counter); }
+  }
+  if (used.empty()) { return; }
+  std::sort(used.begin(), used.end(),
+            [](const ProfileCounter* a, const ProfileCounter* b) { return a->ticks > b->ticks; });
+
+  // convert the ticks with the rate measured over the life of the profiler.
+  double elapsed_ms = std::chrono::duration<double, std::milli>(
+    std::chrono::steady_clock::now() - start_time).count();
+  uint64_t elapsed_ticks = read_timestamp() - start_ticks;
+  double ms_per_tick = (elapsed_ticks > 0 ? elapsed_ms / elapsed_ticks : 0.);
+
+  os << "Profile:: pid " << portable_getpid() << ", " << std::fixed << std::setprecision(1)
+    << elapsed_ms << " ms since the first counter" << std::endl;
+  os << std::left << std::setw(32) << "counter" << std::right
+    << std::setw(12) << "calls" << std::setw(14) << "total_ms"
+    << std::setw(12) << "mean_us" << std::setw(8) << "%" << std::endl;
+  for (const ProfileCounter* counter : used) {
+    double total_ms = counter->ticks * ms_per_tick;
+    os << std::left << std::setw(32) << counter->name << std::right
+      << std::setw(12) << counter->calls
+      << std::setw(14) << std::setprecision(1) << total_ms
+      << std::setw(12) << std::setprecision(2) << total_ms * 1000. / counter->calls
+      << std::setw(8) << std::setprecision(1) << (elapsed_ms > 0 ? total_ms * 100. / elapsed_ms : 0.)
+      << std::endl;
+  }
+}
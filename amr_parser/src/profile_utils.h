@@ -0,0 +1,103 @@
+#ifndef PROFILE_UTILS_H
+#define PROFILE_UTILS_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Low-overhead timing counters read from the time-stamp counter of the CPU
+// (a steady clock on the other platforms). They are compiled out unless the
+// build defines AMR_PROFILE (cmake -DENABLE_PROFILING=ON), and the table of
+// the calls and the time of each counter is written to stderr at exit.
+//
+// The counters are not atomic, they are meant for the single-threaded
+// decoding and training of one process.
+
+uint64_t read_timestamp();
+
+struct ProfileCounter {
+  std::string name;
+  uint64_t ticks;
+  uint64_t calls;
+};
+
+struct Profiler {
+  static Profiler& get();
+
+  // the counter of name, created on the first call. The pointer is valid
+  // till the exit.
+  ProfileCounter* counter(const std::string& name);
+
+  // write the table of the counters sorted by their time.
+  void report(std::ostream& os);
+
+  ~Profiler();
+
+private:
+  Profiler();
+
+  std::mutex mutex;
+  std::deque<ProfileCounter> counters;
+  std::unordered_map<std::string, ProfileCounter*> index;
+  uint64_t start_ticks;
+  std::chrono::steady_clock::time_point start_time;
+
+  Profiler(const Profiler&);
+  Profiler& operator = (const Profiler&);
+};
+
+// The counters of a family keyed by a small integer, e.g. the action id,
+// which is cheaper than looking up the name on each call.
+struct ProfileCounterTable {
+  template <class NameFunc>
+  ProfileCounter* get(unsigned key, NameFunc name) {
+    if (key >= counters.size()) { counters.resize(key + 1, nullptr); }
+    if (counters[key] == nullptr) { counters[key] = Profiler::get().counter(name()); }
+    return counters[key];
+  }
+
+private:
+  std::vector<ProfileCounter*> counters;
+};
+
+// Add the time from the construction to the destruction to the counter.
+struct ProfileScope {
+  explicit ProfileScope(ProfileCounter* counter) :
+    counter(counter), start(read_timestamp()) {}
+
+  ~ProfileScope() {
+    counter->ticks += read_timestamp() - start;
+    ++counter->calls;
+  }
+
+private:
+  ProfileCounter* counter;
+  uint64_t start;
+};
+
+#define PROFILE_CONCAT_IMPL(a, b) a ## b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef AMR_PROFILE
+// time the rest of the enclosing scope under name.
+#define PROFILE_SCOPE(name) \
+  static ProfileCounter* PROFILE_CONCAT(profile_counter_, __LINE__) = Profiler::get().counter(name); \
+  ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(PROFILE_CONCAT(profile_counter_, __LINE__))
+
+// time the rest of the enclosing scope under the counter of key, named by
+// name_expr on the first use of key.
+#define PROFILE_KEYED_SCOPE(key, name_expr) \
+  static ProfileCounterTable PROFILE_CONCAT(profile_table_, __LINE__); \
+  ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)( \
+    PROFILE_CONCAT(profile_table_, __LINE__).get((key), [&]() -> std::string { return (name_expr); }))
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_KEYED_SCOPE(key, name_expr)
+#endif
+
+#endif  //  end for PROFILE_UTILS_H
@@ -1,50 +1,277 @@
-#include "sys_utils.h"
-#include "logging.h"
-#include <boost/algorithm/string.hpp>
-#include <boost/lexical_cast.hpp>
-#include <vector>
-#include <fstream>
-#if _MSC_VER
-#include <process.h>
-#endif
-
-
-int portable_getpid() {
-#ifdef _MSC_VER
-  return _getpid();
-#else
-  return getpid();
-#endif
-}
-
-float execute_and_get_result(const std::string& cmd) {
-  _TRACE << "Running: " << cmd;
-  system(cmd.c_str());
-
-#ifndef _MSC_VER
-  FILE* pipe = popen(cmd.c_str(), "r");
-#else
-  FILE* pipe = _popen(cmd.c_str(), "r");
-#endif
-  if (!pipe) {
-    return 0.f;
-  }
-  char buffer[128];
-  std::string result = "";
-  while (!feof(pipe)) {
-    if (fgets(buffer, 128, pipe) != NULL) { result += buffer; }
-  }
-#ifndef _MSC_VER
-  pclose(pipe);
-#else
-  _pclose(pipe);
-#endif
-
-  std::stringstream S(result);
-  std::string token;
-  while (S >> token) {
-    boost::algorithm::trim(token);
-    return boost::lexical_cast<float>(token);
-  }
-  return 0.f;
-}
+#include "sys_utils.h"
+#include "logging.h"
+#include "trace_utils.h"
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/assert.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filter/bzip2.hpp>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#if _MSC_VER
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#endif
+
+
+int portable_getpid() {
+#ifdef _MSC_VER
+  return _getpid();
+#else
+  return getpid();
+#endif
+}
+
+void get_memory_usage(size_t& rss, size_t& peak_rss) {
+  rss = 0;
+  peak_rss = 0;
+#ifndef _MSC_VER
+  // the second field of statm is the resident pages.
+  std::ifstream ifs("/proc/self/statm");
+  size_t size = 0, resident = 0;
+  if (ifs >> size >> resident) { rss = resident * static_cast<size_t>(sysconf(_SC_PAGESIZE)); }
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+    peak_rss = static_cast<size_t>(usage.ru_maxrss);
+#else
+    peak_rss = static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+  }
+#endif
+}
+
+MappedFile::MappedFile() : addr(nullptr), length(0) {
+
+}
+
+MappedFile::~MappedFile() {
+  close();
+}
+
+const char* MappedFile::open(const std::string& filename) {
+  close();
+#ifndef _MSC_VER
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  BOOST_ASSERT_MSG(fd >= 0, "MappedFile:: failed to open the file.");
+  struct stat st;
+  fstat(fd, &st);
+  length = static_cast<size_t>(st.st_size);
+  if (length > 0) {
+    addr = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    BOOST_ASSERT_MSG(addr != MAP_FAILED, "MappedFile:: failed to map the file.");
+  }
+  ::close(fd);
+#else
+  std::ifstream ifs(filename, std::ios::binary);
+  BOOST_ASSERT_MSG(ifs, "MappedFile:: failed to open the file.");
+  buffer.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+  length = buffer.size();
+#endif
+  return data();
+}
+
+void MappedFile::close() {
+#ifndef _MSC_VER
+  if (addr != nullptr) { munmap(addr, length); }
+#endif
+  buffer.clear();
+  addr = nullptr;
+  length = 0;
+}
+
+const char* MappedFile::data() const {
+  if (addr != nullptr) { return static_cast<const char*>(addr); }
+  return buffer.data();
+}
+
+size_t MappedFile::size() const {
+  return length;
+}
+
+namespace {
+
+/// The number of decompressed pieces waiting to be parsed.
+const size_t kMaxPieces = 2;
+
+bool is_blank(const char* p, const char* end) {
+  for (; p < end; ++p) {
+    if (*p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') { return false; }
+  }
+  return true;
+}
+
+/// The position after the last boundary in buf, 0 if there is none.
+size_t find_cut(const std::string& buf, ChunkReader::Boundary boundary) {
+  size_t end = buf.rfind('\n');
+  if (end == std::string::npos) { return 0; }
+  if (boundary == ChunkReader::kLine) { return end + 1; }
+  while (true) {
+    size_t begin = (end == 0 ? std::string::npos : buf.rfind('\n', end - 1));
+    size_t line_begin = (begin == std::string::npos ? 0 : begin + 1);
+    if (is_blank(buf.data() + line_begin, buf.data() + end)) { return end + 1; }
+    if (begin == std::string::npos) { return 0; }
+    end = begin;
+  }
+}
+
+}
+
+ChunkReader::ChunkReader() :
+  boundary(kLine), piece_size(0), compressed(false), mapped_done(false),
+  finished(false), stopped(false), chunk_end(0) {
+
+}
+
+ChunkReader::~ChunkReader() {
+  close();
+}
+
+bool ChunkReader::is_compressed(const std::string& filename) {
+  return (boost::algorithm::ends_with(filename, ".gz") ||
+          boost::algorithm::ends_with(filename, ".bz2"));
+}
+
+void ChunkReader::open(const std::string& filename, Boundary b, size_t size) {
+  close();
+  boundary = b;
+  piece_size = size;
+  compressed = is_compressed(filename);
+  if (!compressed) {
+    file.open(filename);
+    return;
+  }
+  source.open(filename, std::ios::binary);
+  if (!source) {
+    _ERROR << "ChunkReader:: failed to open " << filename;
+    abort();
+  }
+  worker = std::thread(&ChunkReader::decompress, this, filename);
+}
+
+void ChunkReader::close() {
+  if (worker.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopped = true;
+    }
+    cond.notify_all();
+    worker.join();
+  }
+  if (source.is_open()) { source.close(); }
+  source.clear();
+  file.close();
+  pieces.clear();
+  chunk.clear();
+  error.clear();
+  chunk_end = 0;
+  mapped_done = false;
+  finished = false;
+  stopped = false;
+}
+
+void ChunkReader::decompress(std::string filename) {
+  try {
+    boost::iostreams::filtering_istream in;
+    if (boost::algorithm::ends_with(filename, ".gz")) {
+      in.push(boost::iostreams::gzip_decompressor());
+    } else {
+      in.push(boost::iostreams::bzip2_decompressor());
+    }
+    in.push(source);
+    while (true) {
+      std::string piece(piece_size, '\0');
+      in.read(&piece[0], piece_size);
+      piece.resize(static_cast<size_t>(in.gcount()));
+      if (piece.empty()) { break; }
+      std::unique_lock<std::mutex> lock(mutex);
+      cond.wait(lock, [this]() { return stopped || pieces.size() < kMaxPieces; });
+      if (stopped) { return; }
+      pieces.push_back(std::move(piece));
+      cond.notify_all();
+    }
+  } catch (const std::exception& e) {
+    std::lock_guard<std::mutex> lock(mutex);
+    error = e.what();
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  finished = true;
+  cond.notify_all();
+}
+
+bool ChunkReader::next(const char*& data, size_t& size) {
+  if (!compressed) {
+    if (mapped_done || file.size() == 0) { return false; }
+    mapped_done = true;
+    data = file.data();
+    size = file.size();
+    return true;
+  }
+
+  chunk.erase(0, chunk_end);
+  chunk_end = 0;
+  while (chunk_end == 0) {
+    std::string piece;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cond.wait(lock, [this]() { return finished || !pieces.empty(); });
+      if (pieces.empty()) {
+        if (!error.empty()) {
+          _ERROR << "ChunkReader:: failed to decompress: " << error;
+          abort();
+        }
+        if (chunk.empty()) { return false; }
+        chunk_end = chunk.size();
+        break;
+      }
+      piece = std::move(pieces.front());
+      pieces.pop_front();
+      cond.notify_all();
+    }
+    chunk += piece;
+    chunk_end = find_cut(chunk, boundary);
+  }
+  data = chunk.data();
+  size = chunk_end;
+  return true;
+}
+
+float execute_and_get_result(const std::string& cmd) {
+  _TRACE << "Running: " << cmd;
+  TraceSpan span("external_eval", "evaluate");
+  system(cmd.c_str());
+
+#ifndef _MSC_VER
+  FILE* pipe = popen(cmd.c_str(), "r");
+#else
+  FILE* pipe = _popen(cmd.c_str(), "r");
+#endif
+  if (!pipe) {
+    return 0.f;
+  }
+  char buffer[128];
+  std::string result = "";
+  while (!feof(pipe)) {
+    if (fgets(buffer, 128, pipe) != NULL) { result += buffer; }
+  }
+#ifndef _MSC_VER
+  pclose(pipe);
+#else
+  _pclose(pipe);
+#endif
+
+  std::stringstream S(result);
+  std::string token;
+  while (S >> token) {
+    boost::algorithm::trim(token);
+    return boost::lexical_cast<float>(token);
+  }
+  return 0.f;
+}
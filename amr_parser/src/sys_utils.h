@@ -1,10 +1,92 @@
-#ifndef SYS_UTILS_H
-#define SYS_UTILS_H
-
-#include <iostream>
-
-int portable_getpid();
-
-float execute_and_get_result(const std::string& cmd);
-
+#ifndef SYS_UTILS_H
+#define SYS_UTILS_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+int portable_getpid();
+
+// The resident set size of this process and its peak in bytes, 0 if the
+// platform does not tell.
+void get_memory_usage(size_t& rss, size_t& peak_rss);
+
+// A read-only, memory-mapped view of a whole file. On the platforms without
+// mmap, the file is read into a buffer.
+struct MappedFile {
+  MappedFile();
+  ~MappedFile();
+
+  // map the file, return the pointer to the first byte.
+  const char* open(const std::string& filename);
+  void close();
+
+  const char* data() const;
+  size_t size() const;
+
+private:
+  void* addr;
+  size_t length;
+  std::vector<char> buffer;
+
+  MappedFile(const MappedFile&);
+  MappedFile& operator = (const MappedFile&);
+};
+
+// Read a plain, gzip (.gz) or bzip2 (.bz2) text file as a sequence of
+// chunks. A plain file is mapped and read as a single chunk. A compressed
+// file is decompressed by a background thread into pieces of piece_size
+// bytes while the caller parses the previous chunk; the chunks are cut after
+// the last newline (kLine) or the last blank line (kBlock), so no line or
+// block spans two chunks.
+struct ChunkReader {
+  enum Boundary { kLine, kBlock };
+
+  ChunkReader();
+  ~ChunkReader();
+
+  void open(const std::string& filename,
+            Boundary boundary = kLine,
+            size_t piece_size = (1 << 24));
+  void close();
+
+  // get the next chunk, it is valid until the next call.
+  bool next(const char*& data, size_t& size);
+
+  static bool is_compressed(const std::string& filename);
+
+private:
+  void decompress(std::string filename);
+
+  Boundary boundary;
+  size_t piece_size;
+  bool compressed;
+
+  // plain file.
+  MappedFile file;
+  bool mapped_done;
+
+  // compressed file, the pieces are passed from the decompressing thread.
+  std::ifstream source;  // read by the decompressing thread.
+  std::thread worker;
+  std::mutex mutex;
+  std::condition_variable cond;
+  std::deque<std::string> pieces;
+  bool finished;
+  bool stopped;
+  std::string error;
+  std::string chunk;  // the returned chunk and the carried tail.
+  size_t chunk_end;
+
+  ChunkReader(const ChunkReader&);
+  ChunkReader& operator = (const ChunkReader&);
+};
+
+float execute_and_get_result(const std::string& cmd);
+
 #endif  //  end for SYS_UTILS_H
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include "trace_utils.h"
+#include "logging.h"
+#include "sys_utils.h"
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <boost/lexical_cast.hpp>
+#ifndef _MSC_VER
+#include <pthread.h>
+#endif
+
+namespace {
+
+/// A small id of the calling thread, the viewer draws one row per id.
+unsigned get_thread_id() {
+  static std::atomic<unsigned> n_threads(0);
+  thread_local unsigned tid = ++n_threads;
+  return tid;
+}
+
+}
+
+TraceRecorder::TraceRecorder() :
+  opened(false), forked(false), n_events(0) {
+}
+
+TraceRecorder::~TraceRecorder() {
+  close();
+}
+
+TraceRecorder& TraceRecorder::get() {
+  static TraceRecorder recorder;
+  return recorder;
+}
+
+void TraceRecorder::open(const std::string& name) {
+  std::lock_guard<std::mutex> lock(mutex);
+  ofs.open(name);
+  if (!ofs) {
+    _WARN << "Trace:: failed to open " << name << ", no trace is recorded.";
+    return;
+  }
+  filename = name;
+  opened = true;
+  forked = false;
+  n_events = 0;
+  ofs << "[";
+#ifndef _MSC_VER
+  static bool registered = false;
+  if (!registered) {
+    pthread_atfork(&TraceRecorder::before_fork,
+                   &TraceRecorder::after_fork_in_parent,
+                   &TraceRecorder::after_fork_in_child);
+    registered = true;
+  }
+#endif
+  _INFO << "Trace:: write the trace events to " << filename;
+}
+
+void TraceRecorder::close() {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!opened) { return; }
+  // the file of a forked process without any event is still its parent's.
+  if (!forked) { ofs << "\n]\n"; }
+  ofs.close();
+  opened = false;
+}
+
+bool TraceRecorder::enabled() const {
+  return opened;
+}
+
+uint64_t TraceRecorder::now_us() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void TraceRecorder::set_process_name(const std::string& name) {
+  if (!opened) { return; }
+  std::ostringstream os;
+  os << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << portable_getpid()
+    << ",\"args\":{\"name\":\"" << name << "\"}}";
+  write_event(os.str());
+}
+
+void TraceRecorder::complete(const char* name,
+                             const char* category,
+                             uint64_t start_us,
+                             uint64_t end_us,
+                             const std::string& args) {
+  if (!opened) { return; }
+  std::ostringstream os;
+  os << "{\"name\":\"" << name << "\",\"cat\":\"" << category << "\",\"ph\":\"X\",\"ts\":" << start_us
+    << ",\"dur\":" << (end_us - start_us) << ",\"pid\":" << portable_getpid()
+    << ",\"tid\":" << get_thread_id() << ",\"args\":{" << args << "}}";
+  write_event(os.str());
+}
+
+void TraceRecorder::write_event(const std::string& event) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!opened) { return; }
+  if (forked) { reopen_in_child(); }
+  ofs << (n_events++ == 0 ? "\n" : ",\n") << event;
+}
+
+void TraceRecorder::reopen_in_child() {
+  // the buffer was flushed before the fork, closing the inherited stream
+  // writes nothing to the parent's file.
+  ofs.close();
+  ofs.open(filename + "." + boost::lexical_cast<std::string>(portable_getpid()));
+  ofs << "[";
+  forked = false;
+  n_events = 0;
+}
+
+void TraceRecorder::before_fork() {
+  TraceRecorder& recorder = get();
+  recorder.mutex.lock();
+  if (recorder.opened) { recorder.ofs.flush(); }
+}
+
+void TraceRecorder::after_fork_in_parent() {
+  get().mutex.unlock();
+}
+
+void TraceRecorder::after_fork_in_child() {
+  TraceRecorder& recorder = get();
+  if (recorder.opened) { recorder.forked = true; }
+  recorder.mutex.unlock();
+}
+
+TraceSpan::TraceSpan(const char* name, const char* category) :
+  name(name), category(category), start(0), active(TraceRecorder::get().enabled()) {
+  if (active) { start = TraceRecorder::now_us(); }
+}
+
+TraceSpan::~TraceSpan() {
+  end();
+}
+
+void TraceSpan::add_arg(const char* key, long value) {
+  if (!active) { return; }
+  if (!args.empty()) { args += ","; }
+  args += "\"";
+  args += key;
+  args += "\":";
+  args += boost::lexical_cast<std::string>(value);
+}
+
+void TraceSpan::end() {
+  if (!active) { return; }
+  TraceRecorder::get().complete(name, category, start, TraceRecorder::now_us(), args);
+  active = false;
+}
@@ -0,0 +1,77 @@
+#ifndef TRACE_UTILS_H
+#define TRACE_UTILS_H
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+
+// Record the spans of a run in the Chrome trace event format, to be opened in
+// chrome://tracing or Perfetto. The events are streamed to the file as the
+// spans end. A forked process (a training worker or a background evaluation)
+// writes to <filename>.<pid> from its first event on; all the files of a run
+// share the monotonic clock and can be loaded together.
+struct TraceRecorder {
+  static TraceRecorder& get();
+
+  void open(const std::string& filename);
+  void close();
+  bool enabled() const;
+
+  // name this process in the viewer, e.g. "worker 1".
+  void set_process_name(const std::string& name);
+
+  // a complete event from start_us to end_us, args is the content of a json
+  // object or empty.
+  void complete(const char* name,
+                const char* category,
+                uint64_t start_us,
+                uint64_t end_us,
+                const std::string& args);
+
+  static uint64_t now_us();
+
+  ~TraceRecorder();
+
+private:
+  TraceRecorder();
+
+  void write_event(const std::string& event);
+  void reopen_in_child();
+
+  static void before_fork();
+  static void after_fork_in_parent();
+  static void after_fork_in_child();
+
+  std::mutex mutex;
+  std::ofstream ofs;
+  std::string filename;
+  bool opened;
+  bool forked;
+  unsigned n_events;
+
+  TraceRecorder(const TraceRecorder&);
+  TraceRecorder& operator = (const TraceRecorder&);
+};
+
+// A span from the construction to end() or the destruction. Nothing is
+// recorded if the recorder is not open.
+struct TraceSpan {
+  TraceSpan(const char* name, const char* category);
+  ~TraceSpan();
+
+  void add_arg(const char* key, long value);
+  void end();
+
+private:
+  const char* name;
+  const char* category;
+  std::string args;
+  uint64_t start;
+  bool active;
+
+  TraceSpan(const TraceSpan&);
+  TraceSpan& operator = (const TraceSpan&);
+};
+
+#endif  //  end for TRACE_UTILS_H
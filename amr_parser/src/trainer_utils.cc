@@ -1,124 +1,351 @@
-#include "trainer_utils.h"
-#include "sys_utils.h"
-#include "logging.h"
-#include <fstream>
-#include <sstream>
-
-void random_replace_singletons(const unsigned & unk_strategy,
-                               const float & unk_prob,
-                               const std::set<unsigned>& singletons,
-                               const unsigned& kUNK,
-                               InputUnits & input_units) {
-  if (unk_strategy != 1) { return; }
-  for (auto& u : input_units) {
-    if (singletons.count(u.wid) && dynet::rand01() < unk_prob) { u.wid = kUNK; }
-  }
-}
-
-void restore_singletons(const unsigned & unk_strategy,
-                        InputUnits & input_units) {
-  if (unk_strategy != 1) { return; }  
-  for (auto& u : input_units) { u.wid = u.aux_wid; }
-}
-
-void get_orders(Corpus& corpus,
-                std::vector<unsigned>& order) {
-  order.clear();
-  for (unsigned i = 0; i < corpus.training_inputs.size(); ++i) {
-    order.push_back(i);
-  }
-}
-
-std::string get_model_name(const po::variables_map& conf,
-                           const std::string& prefix) {
-  std::ostringstream os;
-  os << prefix << "." << portable_getpid();
-  return os.str();
-}
-
-po::options_description get_optimizer_options() {
-  po::options_description cmd("Optimizer options");
-  cmd.add_options()
-    ("optimizer", po::value<std::string>()->default_value("simple_sgd"), "The choice of optimizer [simple_sgd, momentum_sgd, adagrad, adadelta, adam].")
-    ("optimizer_eta", po::value<float>(), "The initial value of learning rate (eta).")
-    ("optimizer_final_eta", po::value<float>()->default_value(0.f), "The final value of eta.")
-    ("optimizer_enable_eta_decay", po::value<bool>()->required(), "Specify to update eta at the end of each epoch.")
-    ("optimizer_eta_decay", po::value<float>(), "The decay rate of eta.")
-    ("optimizer_enable_clipping", po::value<bool>()->required(), "Enable clipping.")
-    ("optimizer_adam_beta1", po::value<float>()->default_value(0.9f), "The beta1 hyper-parameter of adam")
-    ("optimizer_adam_beta2", po::value<float>()->default_value(0.999f), "The beta2 hyper-parameter of adam.")
-    ("optimizer_rmsprop_rho", po::value<float>()->default_value(0.99f), "The rho hyper-parameter of rmsprop.")
-    ;
-
-  return cmd;
-}
-
-dynet::Trainer* get_trainer(const po::variables_map& conf, dynet::ParameterCollection& model) {
-  dynet::Trainer* trainer = nullptr;
-  if (!conf.count("optimizer") || conf["optimizer"].as<std::string>() == "simple_sgd") {
-    float eta0 = (conf.count("optimizer_eta") ? conf["optimizer_eta"].as<float>() : 0.1f);
-    trainer = new dynet::SimpleSGDTrainer(model, eta0);
-    // trainer->eta_decay = 0.08f;
-  } else if (conf["optimizer"].as<std::string>() == "momentum_sgd") {
-    trainer = new dynet::MomentumSGDTrainer(model);
-    // trainer->eta_decay = 0.08f;
-  } else if (conf["optimizer"].as<std::string>() == "adagrad") {
-    trainer = new dynet::AdagradTrainer(model);
-  } else if (conf["optimizer"].as<std::string>() == "adadelta") {
-    trainer = new dynet::AdadeltaTrainer(model);
-  } else if (conf["optimizer"].as<std::string>() == "rmsprop") {
-    float eta0 = (conf.count("optimizer_eta") ? conf["optimizer_eta"].as<float>() : 0.001f);
-    float rho = (conf.count("optimizer_rmsprop_rho") ? conf["optimizer_rmsprop_rho"].as<float>() : 0.99f);
-    trainer = new dynet::RMSPropTrainer(model, eta0, 1e-8, rho);
-  } else if (conf["optimizer"].as<std::string>() == "adam") {
-    // default setting is same with Kingma and Ba (2015). 
-    float eta0 = (conf.count("optimizer_eta") ? conf["optimizer_eta"].as<float>() : 0.001f);
-    float beta1 = conf["optimizer_adam_beta1"].as<float>();
-    float beta2 = conf["optimizer_adam_beta2"].as<float>();
-    trainer = new dynet::AdamTrainer(model, eta0, beta1, beta2);
-  } else {
-    _ERROR << "Trainier:: unknown optimizer: " << conf["optimizer"].as<std::string>();
-    exit(1);
-  }
-  _INFO << "Trainer:: using " << conf["optimizer"].as<std::string>() << " optimizer";
-  _INFO << "Trainer:: eta = " << trainer->learning_rate;
-
-  if (conf["optimizer_enable_clipping"].as<bool>()) {
-    trainer->clipping_enabled = true;
-    _INFO << "Trainer:: gradient clipping = enabled";
-  } else {
-    trainer->clipping_enabled = false;
-    _INFO << "Trainer:: gradient clipping = false";
-  }
-
-  if (conf["optimizer_enable_eta_decay"].as<bool>()) {
-    _INFO << "Trainer:: eta decay = enabled";
-    if (conf.count("optimizer_eta_decay")) {
-      // trainer->eta_decay = conf["optimizer_eta_decay"].as<float>();
-      _INFO << "Trainer:: eta decay rate = " << conf["optimizer_eta_decay"].as<float>();
-    } else {
-      _INFO << "Trainer:: eta decay rate not set, use default = " << 0.08f;
-    }
-  } else {
-    _INFO << "Trainer:: eta decay = disabled";
-  }
-  return trainer;
-}
-
-void update_trainer(const po::variables_map& conf, const float & eta0, const float & iter, dynet::Trainer* trainer) {
-  if (conf.count("optimizer_enable_eta_decay")) {
-    float final_eta = conf["optimizer_final_eta"].as<float>();
-    float eta_decay = (conf.count("optimizer_eta_decay") ? conf["optimizer_eta_decay"].as<float>() : 0.08f);
-    if (trainer->learning_rate > final_eta) {
-      // trainer->update_epoch();
-      // trainer->status();
-      trainer->learning_rate = eta0 / (1.f + eta_decay * iter);
-      _INFO << "Trainer:: trainer updated.";
-    } else {
-      trainer->learning_rate = final_eta;
-      _INFO << "Trainer:: eta reach the final value " << final_eta;
-    }
-  }
-}
-
-
+#include "trainer_utils.h"
+#include "sys_utils.h"
+#include "logging.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <boost/assert.hpp>
+
+InputUnits random_replace_singletons(const unsigned & unk_strategy,
+                                     const float & unk_prob,
+                                     const IdBitmap& singletons,
+                                     const unsigned& kUNK,
+                                     const InputUnits & input_units,
+                                     std::vector<unsigned>& wids) {
+  if (unk_strategy != 1) { return input_units; }
+  wids.assign(input_units.wids, input_units.wids + input_units.size());
+  for (unsigned& wid : wids) {
+    if (singletons.count(wid) && dynet::rand01() < unk_prob) { wid = kUNK; }
+  }
+  return input_units.with_wids(wids.data());
+}
+
+void get_orders(Corpus& corpus,
+                std::vector<unsigned>& order) {
+  order.clear();
+  for (unsigned i = 0; i < corpus.training_inputs.size(); ++i) {
+    order.push_back(i);
+  }
+}
+
+std::string get_model_name(const po::variables_map& conf,
+                           const std::string& prefix) {
+  std::ostringstream os;
+  os << prefix << "." << portable_getpid();
+  return os.str();
+}
+
+LazyAdamTrainer::LazyAdamTrainer(dynet::ParameterCollection& m,
+                                 float learning_rate,
+                                 float beta1,
+                                 float beta2) :
+  dynet::AdamTrainer(m, learning_rate, beta1, beta2) {
+}
+
+void LazyAdamTrainer::restart() {
+  dynet::AdamTrainer::restart();
+  last_updates.clear();
+}
+
+void LazyAdamTrainer::save(std::ostream& os) {
+  dynet::AdamTrainer::save(os);
+  os << last_updates.size() << '\n';
+  for (const std::vector<unsigned>& last : last_updates) {
+    os << last.size();
+    for (unsigned step : last) { os << ' ' << step; }
+    os << '\n';
+  }
+}
+
+void LazyAdamTrainer::populate(std::istream& is) {
+  dynet::AdamTrainer::populate(is);
+  size_t n = 0;
+  is >> n;
+  last_updates.assign(n, std::vector<unsigned>());
+  for (std::vector<unsigned>& last : last_updates) {
+    size_t m = 0;
+    is >> m;
+    last.resize(m);
+    for (unsigned& step : last) { is >> step; }
+  }
+}
+
+void LazyAdamTrainer::catch_up(size_t idx, size_t lidx) {
+  if (last_updates.size() <= idx) { last_updates.resize(idx + 1); }
+  std::vector<unsigned>& last = last_updates[idx];
+  if (last.size() <= lidx) { last.resize(lidx + 1, 0); }
+
+  unsigned step = static_cast<unsigned>(updates) + 1;
+  if (last[lidx] > 0 && step > last[lidx] + 1) {
+    unsigned skipped = step - last[lidx] - 1;
+    lm[idx].h[lidx].vec() *= std::pow(beta_1, static_cast<float>(skipped));
+    lv[idx].h[lidx].vec() *= std::pow(beta_2, static_cast<float>(skipped));
+  }
+  last[lidx] = step;
+}
+
+void LazyAdamTrainer::update_lookup_params(dynet::real gscale, size_t idx, size_t lidx) {
+  catch_up(idx, lidx);
+  dynet::AdamTrainer::update_lookup_params(gscale, idx, lidx);
+}
+
+void LazyAdamTrainer::update_lookup_params(dynet::real gscale, size_t idx) {
+  for (size_t lidx = 0; lidx < lm[idx].h.size(); ++lidx) { catch_up(idx, lidx); }
+  dynet::AdamTrainer::update_lookup_params(gscale, idx);
+}
+
+namespace {
+
+typedef std::vector<dynet::ShadowParameters> Shadows;
+typedef std::vector<dynet::ShadowLookupParameters> LookupShadows;
+
+// The shadow tensors and their allocation are protected in DyNet, they are
+// reached through pointers to members formed in derived classes.
+struct TrainerAccess : public dynet::Trainer {
+  static void allocate(dynet::Trainer& t) {
+    (t.*(&TrainerAccess::alloc_impl))();
+    (t.*(&TrainerAccess::alloc_lookup_impl))();
+  }
+};
+
+struct MomentumAccess : public dynet::MomentumSGDTrainer {
+  static void get(dynet::MomentumSGDTrainer& t, std::vector<Shadows*>& sp, std::vector<LookupShadows*>& slp) {
+    sp.push_back(&(t.*(&MomentumAccess::vp)));
+    slp.push_back(&(t.*(&MomentumAccess::vlp)));
+  }
+};
+
+struct AdagradAccess : public dynet::AdagradTrainer {
+  static void get(dynet::AdagradTrainer& t, std::vector<Shadows*>& sp, std::vector<LookupShadows*>& slp) {
+    sp.push_back(&(t.*(&AdagradAccess::vp)));
+    slp.push_back(&(t.*(&AdagradAccess::vlp)));
+  }
+};
+
+struct AdadeltaAccess : public dynet::AdadeltaTrainer {
+  static void get(dynet::AdadeltaTrainer& t, std::vector<Shadows*>& sp, std::vector<LookupShadows*>& slp) {
+    sp.push_back(&(t.*(&AdadeltaAccess::hg)));
+    slp.push_back(&(t.*(&AdadeltaAccess::hlg)));
+    sp.push_back(&(t.*(&AdadeltaAccess::hd)));
+    slp.push_back(&(t.*(&AdadeltaAccess::hld)));
+  }
+};
+
+struct RMSPropAccess : public dynet::RMSPropTrainer {
+  static void get(dynet::RMSPropTrainer& t, std::vector<Shadows*>& sp, std::vector<LookupShadows*>& slp) {
+    sp.push_back(&(t.*(&RMSPropAccess::hmsg)));
+    slp.push_back(&(t.*(&RMSPropAccess::hlmsg)));
+  }
+};
+
+struct AdamAccess : public dynet::AdamTrainer {
+  static void get(dynet::AdamTrainer& t, std::vector<Shadows*>& sp, std::vector<LookupShadows*>& slp) {
+    sp.push_back(&(t.*(&AdamAccess::m)));
+    slp.push_back(&(t.*(&AdamAccess::lm)));
+    sp.push_back(&(t.*(&AdamAccess::v)));
+    slp.push_back(&(t.*(&AdamAccess::lv)));
+  }
+};
+
+/// The shadow tensors of the trainer, none for the simple SGD.
+void get_shadows(dynet::Trainer& trainer, std::vector<Shadows*>& sp, std::vector<LookupShadows*>& slp) {
+  if (dynet::AdamTrainer* t = dynamic_cast<dynet::AdamTrainer*>(&trainer)) {
+    AdamAccess::get(*t, sp, slp);
+  } else if (dynet::RMSPropTrainer* t = dynamic_cast<dynet::RMSPropTrainer*>(&trainer)) {
+    RMSPropAccess::get(*t, sp, slp);
+  } else if (dynet::AdadeltaTrainer* t = dynamic_cast<dynet::AdadeltaTrainer*>(&trainer)) {
+    AdadeltaAccess::get(*t, sp, slp);
+  } else if (dynet::AdagradTrainer* t = dynamic_cast<dynet::AdagradTrainer*>(&trainer)) {
+    AdagradAccess::get(*t, sp, slp);
+  } else if (dynet::MomentumSGDTrainer* t = dynamic_cast<dynet::MomentumSGDTrainer*>(&trainer)) {
+    MomentumAccess::get(*t, sp, slp);
+  }
+}
+
+/// Visit the shadow tensors in a fixed order.
+template <class Function>
+void for_each_shadow(const std::vector<Shadows*>& sp, const std::vector<LookupShadows*>& slp, Function f) {
+  for (Shadows* shadows : sp) {
+    for (dynet::ShadowParameters& p : (*shadows)) { f(p.h); }
+  }
+  for (LookupShadows* shadows : slp) {
+    for (dynet::ShadowLookupParameters& p : (*shadows)) { f(p.all_h); }
+  }
+}
+
+}
+
+void save_trainer_state(dynet::Trainer& trainer, TrainerState& state) {
+  std::vector<Shadows*> sp;
+  std::vector<LookupShadows*> slp;
+  get_shadows(trainer, sp, slp);
+  size_t n = 0;
+  for_each_shadow(sp, slp, [&n](dynet::Tensor& t) { n += t.d.size(); });
+  state.values.resize(n);
+  float* out = state.values.data();
+  for_each_shadow(sp, slp, [&out](dynet::Tensor& t) {
+    std::copy(t.v, t.v + t.d.size(), out);
+    out += t.d.size();
+  });
+
+  LazyAdamTrainer* lazy = dynamic_cast<LazyAdamTrainer*>(&trainer);
+  state.last_updates = (lazy ? lazy->last_updates : std::vector<std::vector<unsigned>>());
+}
+
+void load_trainer_state(const TrainerState& state, dynet::Trainer& trainer) {
+  // the shadows are allocated at the first update, a fresh trainer has none.
+  const dynet::ParameterCollection& model = (*trainer.model);
+  if (trainer.aux_allocated < model.parameters_list().size() ||
+      trainer.aux_allocated_lookup < model.lookup_parameters_list().size()) {
+    TrainerAccess::allocate(trainer);
+    trainer.aux_allocated = model.parameters_list().size();
+    trainer.aux_allocated_lookup = model.lookup_parameters_list().size();
+  }
+
+  std::vector<Shadows*> sp;
+  std::vector<LookupShadows*> slp;
+  get_shadows(trainer, sp, slp);
+  size_t n = 0;
+  for_each_shadow(sp, slp, [&n](dynet::Tensor& t) { n += t.d.size(); });
+  BOOST_ASSERT_MSG(n == state.values.size(), "Trainer:: the optimizer state does not match the trainer.");
+  const float* in = state.values.data();
+  for_each_shadow(sp, slp, [&in](dynet::Tensor& t) {
+    std::copy(in, in + t.d.size(), t.v);
+    in += t.d.size();
+  });
+
+  LazyAdamTrainer* lazy = dynamic_cast<LazyAdamTrainer*>(&trainer);
+  if (lazy) { lazy->last_updates = state.last_updates; }
+}
+
+size_t count_parameter_values(const dynet::ParameterCollection& model) {
+  size_t n = 0;
+  for (const auto& p : model.parameters_list()) { n += p->values.d.size(); }
+  for (const auto& p : model.lookup_parameters_list()) { n += p->all_values.d.size(); }
+  return n;
+}
+
+void flatten_parameters(dynet::ParameterCollection& model, float* out) {
+  float scale = model.get_weight_decay().current_weight_decay();
+  for (const auto& p : model.parameters_list()) {
+    size_t n = p->values.d.size();
+    for (size_t i = 0; i < n; ++i) { out[i] = p->values.v[i] * scale; }
+    out += n;
+  }
+  for (const auto& p : model.lookup_parameters_list()) {
+    size_t n = p->all_values.d.size();
+    for (size_t i = 0; i < n; ++i) { out[i] = p->all_values.v[i] * scale; }
+    out += n;
+  }
+}
+
+void unflatten_parameters(const float* in, dynet::ParameterCollection& model) {
+  float scale = model.get_weight_decay().current_weight_decay();
+  for (const auto& p : model.parameters_list()) {
+    size_t n = p->values.d.size();
+    for (size_t i = 0; i < n; ++i) { p->values.v[i] = in[i] / scale; }
+    in += n;
+  }
+  for (const auto& p : model.lookup_parameters_list()) {
+    size_t n = p->all_values.d.size();
+    for (size_t i = 0; i < n; ++i) { p->all_values.v[i] = in[i] / scale; }
+    in += n;
+  }
+}
+
+po::options_description get_optimizer_options() {
+  po::options_description cmd("Optimizer options");
+  cmd.add_options()
+    ("optimizer", po::value<std::string>()->default_value("simple_sgd"), "The choice of optimizer [simple_sgd, momentum_sgd, adagrad, adadelta, rmsprop, adam, lazy_adam].")
+    ("optimizer_eta", po::value<float>(), "The initial value of learning rate (eta).")
+    ("optimizer_final_eta", po::value<float>()->default_value(0.f), "The final value of eta.")
+    ("optimizer_enable_eta_decay", po::value<bool>()->required(), "Specify to update eta at the end of each epoch.")
+    ("optimizer_eta_decay", po::value<float>(), "The decay rate of eta.")
+    ("optimizer_enable_clipping", po::value<bool>()->required(), "Enable clipping.")
+    ("optimizer_adam_beta1", po::value<float>()->default_value(0.9f), "The beta1 hyper-parameter of adam")
+    ("optimizer_adam_beta2", po::value<float>()->default_value(0.999f), "The beta2 hyper-parameter of adam.")
+    ("optimizer_rmsprop_rho", po::value<float>()->default_value(0.99f), "The rho hyper-parameter of rmsprop.")
+    ("optimizer_sparse_updates", po::value<bool>()->default_value(true), "Only update the embedding rows touched since the last update.")
+    ;
+
+  return cmd;
+}
+
+dynet::Trainer* get_trainer(const po::variables_map& conf, dynet::ParameterCollection& model) {
+  dynet::Trainer* trainer = nullptr;
+  if (!conf.count("optimizer") || conf["optimizer"].as<std::string>() == "simple_sgd") {
+    float eta0 = (conf.count("optimizer_eta") ? conf["optimizer_eta"].as<float>() : 0.1f);
+    trainer = new dynet::SimpleSGDTrainer(model, eta0);
+    // trainer->eta_decay = 0.08f;
+  } else if (conf["optimizer"].as<std::string>() == "momentum_sgd") {
+    trainer = new dynet::MomentumSGDTrainer(model);
+    // trainer->eta_decay = 0.08f;
+  } else if (conf["optimizer"].as<std::string>() == "adagrad") {
+    trainer = new dynet::AdagradTrainer(model);
+  } else if (conf["optimizer"].as<std::string>() == "adadelta") {
+    trainer = new dynet::AdadeltaTrainer(model);
+  } else if (conf["optimizer"].as<std::string>() == "rmsprop") {
+    float eta0 = (conf.count("optimizer_eta") ? conf["optimizer_eta"].as<float>() : 0.001f);
+    float rho = (conf.count("optimizer_rmsprop_rho") ? conf["optimizer_rmsprop_rho"].as<float>() : 0.99f);
+    trainer = new dynet::RMSPropTrainer(model, eta0, 1e-8, rho);
+  } else if (conf["optimizer"].as<std::string>() == "adam") {
+    // default setting is same with Kingma and Ba (2015). 
+    float eta0 = (conf.count("optimizer_eta") ? conf["optimizer_eta"].as<float>() : 0.001f);
+    float beta1 = conf["optimizer_adam_beta1"].as<float>();
+    float beta2 = conf["optimizer_adam_beta2"].as<float>();
+    trainer = new dynet::AdamTrainer(model, eta0, beta1, beta2);
+  } else if (conf["optimizer"].as<std::string>() == "lazy_adam") {
+    float eta0 = (conf.count("optimizer_eta") ? conf["optimizer_eta"].as<float>() : 0.001f);
+    float beta1 = conf["optimizer_adam_beta1"].as<float>();
+    float beta2 = conf["optimizer_adam_beta2"].as<float>();
+    trainer = new LazyAdamTrainer(model, eta0, beta1, beta2);
+  } else {
+    _ERROR << "Trainier:: unknown optimizer: " << conf["optimizer"].as<std::string>();
+    exit(1);
+  }
+  _INFO << "Trainer:: using " << conf["optimizer"].as<std::string>() << " optimizer";
+  _INFO << "Trainer:: eta = " << trainer->learning_rate;
+
+  trainer->sparse_updates_enabled = conf["optimizer_sparse_updates"].as<bool>();
+  _INFO << "Trainer:: sparse updates = " << (trainer->sparse_updates_enabled ? "enabled" : "disabled");
+
+  if (conf["optimizer_enable_clipping"].as<bool>()) {
+    trainer->clipping_enabled = true;
+    _INFO << "Trainer:: gradient clipping = enabled";
+  } else {
+    trainer->clipping_enabled = false;
+    _INFO << "Trainer:: gradient clipping = false";
+  }
+
+  if (conf["optimizer_enable_eta_decay"].as<bool>()) {
+    _INFO << "Trainer:: eta decay = enabled";
+    if (conf.count("optimizer_eta_decay")) {
+      // trainer->eta_decay = conf["optimizer_eta_decay"].as<float>();
+      _INFO << "Trainer:: eta decay rate = " << conf["optimizer_eta_decay"].as<float>();
+    } else {
+      _INFO << "Trainer:: eta decay rate not set, use default = " << 0.08f;
+    }
+  } else {
+    _INFO << "Trainer:: eta decay = disabled";
+  }
+  return trainer;
+}
+
+void update_trainer(const po::variables_map& conf, const float & eta0, const float & iter, dynet::Trainer* trainer) {
+  if (conf.count("optimizer_enable_eta_decay")) {
+    float final_eta = conf["optimizer_final_eta"].as<float>();
+    float eta_decay = (conf.count("optimizer_eta_decay") ? conf["optimizer_eta_decay"].as<float>() : 0.08f);
+    if (trainer->learning_rate > final_eta) {
+      // trainer->update_epoch();
+      // trainer->status();
+      trainer->learning_rate = eta0 / (1.f + eta_decay * iter);
+      _INFO << "Trainer:: trainer updated.";
+    } else {
+      trainer->learning_rate = final_eta;
+      _INFO << "Trainer:: eta reach the final value " << final_eta;
+    }
+  }
+}
+
+
@@ -1,38 +1,99 @@
-#ifndef TRAIN_UTILS_H
-#define TRAIN_UTILS_H
-
-#include <iostream>
-#include <set>
-#include <boost/program_options.hpp>
-#include "corpus.h"
-#include "dynet/model.h"
-#include "dynet/training.h"
-
-namespace po = boost::program_options;
-
-void random_replace_singletons(const unsigned& unk_strategy,
-                               const float& unk_prob,
-                               const std::set<unsigned>& singletons,
-                               const unsigned& kUNK,
-                               InputUnits& units);
-
-void restore_singletons(const unsigned& unk_strategy,
-                        InputUnits& units);
-
-void get_orders(Corpus& corpus,
-                std::vector<unsigned>& order);
-
-po::options_description get_optimizer_options();
-
-dynet::Trainer* get_trainer(const po::variables_map& conf,
-                            dynet::ParameterCollection& model);
-
-void update_trainer(const po::variables_map& conf,
-                    const float & eta0,
-                    const float & iter,
-                    dynet::Trainer* trainer);
-
-std::string get_model_name(const po::variables_map& conf,
-                           const std::string& prefix);
-
+#ifndef TRAIN_UTILS_H
+#define TRAIN_UTILS_H
+
+#include <iostream>
+#include <set>
+#include <boost/program_options.hpp>
+#include "corpus.h"
+#include "dynet/model.h"
+#include "dynet/training.h"
+
+namespace po = boost::program_options;
+
+// Replace the singletons with UNK in a copy of the word ids (wids), return
+// the sentence reading its word ids from the copy.
+InputUnits random_replace_singletons(const unsigned& unk_strategy,
+                                     const float& unk_prob,
+                                     const IdBitmap& singletons,
+                                     const unsigned& kUNK,
+                                     const InputUnits& units,
+                                     std::vector<unsigned>& wids);
+
+void get_orders(Corpus& corpus,
+                std::vector<unsigned>& order);
+
+// The optimizer state in raw form: the shadow tensors (the moments) of the
+// trainer in the order of the collection, and the update stamps of the lazy
+// Adam. Taking it copies the tensors, the serialization is left to the
+// caller, so it can run off the training thread.
+struct TrainerState {
+  std::vector<float> values;
+  std::vector<std::vector<unsigned>> last_updates;
+
+  friend class boost::serialization::access;
+  template <class Archive>
+  void serialize(Archive& ar, const unsigned version) {
+    ar & values;
+    ar & last_updates;
+  }
+};
+
+void save_trainer_state(dynet::Trainer& trainer, TrainerState& state);
+
+// restore into a trainer of the same type over a model of the same architecture.
+void load_trainer_state(const TrainerState& state, dynet::Trainer& trainer);
+
+// Adam with lazy sparse updates of the lookup parameters: only the rows
+// touched since the last update are visited, and a row skipped by k updates
+// has its first and second moments decayed by beta1^k and beta2^k when it is
+// touched again, which is where the dense Adam would have brought them with
+// zero gradients. The moments are scaled on the host, so it needs the CPU
+// backend.
+struct LazyAdamTrainer : public dynet::AdamTrainer {
+  LazyAdamTrainer(dynet::ParameterCollection& m,
+                  float learning_rate,
+                  float beta1,
+                  float beta2);
+
+  void restart() override;
+
+  // the moments are saved by the AdamTrainer, the update stamps follow them.
+  void save(std::ostream& os) override;
+  void populate(std::istream& is) override;
+
+protected:
+  void update_lookup_params(dynet::real gscale, size_t idx, size_t lidx) override;
+  void update_lookup_params(dynet::real gscale, size_t idx) override;
+
+private:
+  void catch_up(size_t idx, size_t lidx);
+
+  // the 1-based update at which a row was last updated, 0 for never.
+  std::vector<std::vector<unsigned>> last_updates;
+
+  friend void save_trainer_state(dynet::Trainer& trainer, TrainerState& state);
+  friend void load_trainer_state(const TrainerState& state, dynet::Trainer& trainer);
+};
+
+// The values of all the parameters and lookup parameters, in the order of
+// the collection, with the pending weight decay folded in.
+size_t count_parameter_values(const dynet::ParameterCollection& model);
+
+void flatten_parameters(dynet::ParameterCollection& model, float* out);
+
+void unflatten_parameters(const float* in, dynet::ParameterCollection& model);
+
+po::options_description get_optimizer_options();
+
+dynet::Trainer* get_trainer(const po::variables_map& conf,
+                            dynet::ParameterCollection& model);
+
+void update_trainer(const po::variables_map& conf,
+                    const float & eta0,
+                    const float & iter,
+                    dynet::Trainer* trainer);
+
+std::string get_model_name(const po::variables_map& conf,
+                           const std::string& prefix);
+
 #endif  //  end for TRAIN_H
\ No newline at end of file